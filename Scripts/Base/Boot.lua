@@ -8,8 +8,8 @@ return {
 	"FuncOps",
 	"LazyOps",
 	"TableOps",
-	"Coroutine",
 	"CoroutineOps",
+	"Coroutine",
 	"Class",
 	"VarDump"
 }, ...
\ No newline at end of file
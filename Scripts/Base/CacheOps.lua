@@ -14,6 +14,9 @@ local IsTable = var_preds.IsTable
 local UnpackAndWipe = var_ops.UnpackAndWipe
 local WipeRange = var_ops.WipeRange
 
+-- Native table pool, unless disabled at boot --
+local Pool = UseNativeTablePool ~= false and table_pool
+
 --- This module defines some common caching operations.
 module "cache_ops"
 
@@ -63,6 +66,45 @@ function WipeAndRecache (cache, array, count, wipe)
 	return WipeRange(array, 1, count, wipe)
 end
 
+-- Builds a cache backed by the native table pool
+-- on_restore: Restore logic, as per TableCache
+-- Returns: Cache function
+local function PooledTableCache (on_restore)
+	local Get, Put, PutAndUnpack = Pool.Get, Pool.Put, Pool.PutAndUnpack
+
+	return function(t_, ...)
+		if t_ == "pull" then
+			return Get(...)
+		elseif t_ ~= "peek" then
+			assert(IsTable(t_), "Attempt to return non-table")
+
+			-- The pool does the wiping, so only the results need to be supplied. It also sizes
+			-- the table itself, so no range is passed along: a caller's first argument need
+			-- not be the array size.
+			if on_restore == "unpack_and_wipe" then
+				return PutAndUnpack(t_, ...)
+			elseif on_restore == "wipe_range" then
+				Put(t_)
+
+				return t_
+			elseif on_restore then
+				on_restore(t_, ...)
+			end
+
+			Put(t_)
+		end
+	end
+end
+
+--- Reports on the native table pool.
+-- @return If the pool is available, hits, misses, discarded tables, retained tables, and
+-- an estimate of the bytes retained; otherwise, nothing.
+function GetPoolStats ()
+	if Pool then
+		return Pool.GetStats()
+	end
+end
+
 -- Table restore options --
 local TableOptions = { unpack_and_wipe = UnpackWipeAndRecache, wipe_range = WipeAndRecache }
 
@@ -81,13 +123,24 @@ local TableOptions = { unpack_and_wipe = UnpackWipeAndRecache, wipe_range = Wipe
 -- Otherwise, the first argument must be table (though it need not have belonged to the
 -- cache). Any restore logic will be called, passing this table and any additional arguments.
 -- The table will then be restored to the cache.
+-- @param pooled If true and the native table pool is available, tables are drawn from and
+-- restored to the pool, which is shared by all pooled caches. In this case, tables are
+-- emptied and lose any metatable once restored (after any restore logic); weak tables and
+-- tables with protected metatables are dropped instead. <b>"peek"</b> always returns <b>nil</b>,
+-- and <b>"pull"</b> accepts array and hash size hints as further arguments.<br><br>
+-- Since restored tables are emptied, a cache whose tables must keep their contents, e.g.
+-- to bind them, should not be pooled.
 -- @see ~var_ops.UnpackAndWipe
 -- @see ~var_ops.WipeRange
-function TableCache (on_restore)
+function TableCache (on_restore, pooled)
 	local option = TableOptions[on_restore]
 
 	assert(option or IsCallableOrNil(on_restore), "Uncallable restore")
 
+	if pooled and Pool then
+		return PooledTableCache(on_restore)
+	end
+
 	local cache = {}
 
 	return function(t_, ...)
@@ -11,6 +11,7 @@ local status = coroutine.status
 local yield = coroutine.yield
 
 -- Modules --
+local coroutine_ops = require("coroutine_ops")
 local func_ops = require("func_ops")
 local iterators = require("iterators")
 local var_ops = require("var_ops")
@@ -22,10 +23,17 @@ local GetLastTraceback = func_ops.GetLastTraceback
 local InstancedAutocacher = iterators.InstancedAutocacher
 local IsCallable = var_preds.IsCallable
 local NoOp = func_ops.NoOp
+local SetStateKey = coroutine_ops.SetStateKey
 local StoreTraceback = func_ops.StoreTraceback
 local UnpackAndWipe = var_ops.UnpackAndWipe
 local WipeRange = var_ops.WipeRange
 
+-- Native coroutine pool, unless disabled at boot --
+local Pool = UseNativeCoroutinePool ~= false and coroutine_pool
+
+-- Thread factory --
+local NewThread = Pool and Pool.Get or create
+
 -- Cached routines --
 local _IsIterationDone_
 local _Reset_
@@ -50,6 +58,15 @@ local _reset = {}
 -- clean up any important state.
 module "coroutine_ex"
 
+--- Reports on the native coroutine pool.
+-- @return If the pool is available, threads created, threads reused, finished threads
+-- not retained, and threads retained; otherwise, nothing.
+function GetPoolStats ()
+	if Pool then
+		return Pool.GetStats()
+	end
+end
+
 --- Builds an instanced autocaching coroutine-based iterator.
 -- @param func Iterator body.
 -- @param on_reset Function called on reset; if <b>nil</b>, this is a no-op.
@@ -129,11 +146,31 @@ function Reset (coro, ...)
 	end
 end
 
+--- Sets the maximum number of idle threads the native coroutine pool keeps, if available.
+-- @param limit Non-negative integer.
+function SetPoolLimit (limit)
+	if Pool then
+		Pool.SetLimit(limit)
+	end
+end
+
+--- Lets go of the idle threads that the native coroutine pool, if available, has not needed
+-- since the previous call. This is meant to be called at quiet moments, e.g. on leaving
+-- a scene, so that a burst of coroutines does not pin memory.
+-- @return Number of threads let go.
+function ShrinkPool ()
+	return Pool and Pool.Shrink() or 0
+end
+
 --- Creates an extended coroutine, exposed by a wrapper function.
 -- @param func Coroutine body.
 -- @param on_reset Function called on reset; if <b>nil</b>, this is a no-op.<br><br>
 -- Note that this will be executed in a protected call, within the context of the resetter.<br>
--- @return Wrapper function.
+-- @return Wrapper function.<br><br>
+-- When the native coroutine pool is available, the body runs on a pooled thread, which
+-- is returned to the pool whenever an iteration ends. Per-coroutine state, as per <b>
+-- coroutine_ops.PerCoroutineFunc</b>, is kept under a key of the wrapper's own instead, so
+-- that it lasts until a reset, as it would on a single thread.
 -- @see Reset
 function Wrap (func, on_reset)
 	on_reset = on_reset or NoOp
@@ -142,11 +179,14 @@ function Wrap (func, on_reset)
 	assert(IsCallable(func), "Uncallable producer")
 	assert(IsCallable(on_reset), "Uncallable reset response")
 
-	-- Wrapper loop
+	-- Wrapper body. With pooled threads, each iteration ends the body, so that its thread
+	-- can go back to the pool; otherwise, it loops, keeping the thread for reuse.
 	local return_count, return_results = -1
 
-	local function Func (func)
-		while true do
+	local function Func (...)
+		return_count, return_results = CollectArgsInto_IfAny(return_results, func(...))
+
+		while not Pool do
 			return_count, return_results = CollectArgsInto_IfAny(return_results, func(yield()))
 		end
 	end
@@ -156,14 +196,18 @@ function Wrap (func, on_reset)
 	-- res_: First result of resume, or error message
 	-- ...: Remaining resume results
 	-- Returns: On success, any results
-	local coro
+	local coro, key
 
 	local function Resume (success, res_, ...)
 		Running[coro] = nil
 
 		-- On a reset, invalidate the coroutine and trigger any response.
 		if res_ == _reset then
-			coro = false
+			if coro and key then
+				SetStateKey(coro, nil)
+			end
+
+			coro, key = false
 
 			success, res_ = pcall(on_reset, ...)
 
@@ -179,13 +223,23 @@ function Wrap (func, on_reset)
 			end
 
 			error(res_, 3)
+		end
+
+		-- If the body finished, recycle its thread.
+		if Pool and return_count >= 0 then
+			SetStateKey(coro, nil)
+
+			Pool.Put(coro)
 
-		-- Otherwise, return results if the body returned anything.
-		elseif return_count > 0 then
+			coro = nil
+		end
+
+		-- Return results if the body returned anything.
+		if return_count > 0 then
 			return UnpackAndWipe(return_results, return_count)
 
 		-- Otherwise, return yield (or empty return) results if no reset occurred.
-		elseif coro then
+		elseif coro ~= nil or return_count == 0 then
 			return res_, ...
 		end
 	end
@@ -203,18 +257,22 @@ function Wrap (func, on_reset)
 		assert(not coro or status(coro) ~= "dead", "Dead coroutine")
 		assert(not Running[coro], "Coroutine already running")
 
-		-- On the first run or after / on a reset, build a fresh coroutine and put it into
-		-- a ready-and-waiting state.
+		-- On a forced reset, bypass running; any iteration in progress is abandoned.
 		return_count = -1
 
-		if coro == nil or arg_ == _reset then
-			coro = create(Func)
+		if arg_ == _reset then
+			return Resume(true, _reset, ...)
+		end
+
+		-- On the first run or after a reset (or, with pooled threads, a finished iteration),
+		-- start the body on a fresh coroutine.
+		if coro == nil then
+			coro = NewThread(Func)
 
-			resume(coro, func)
+			if Pool then
+				key = key or {}
 
-			-- On a forced reset, bypass running.
-			if arg_ == _reset then
-				return Resume(true, _reset, ...)
+				SetStateKey(coro, key)
 			end
 		end
 
@@ -31,15 +31,25 @@ local _Body_Timed_
 module "coroutine_ops"
 
 do
+	-- Keys standing in for coroutines in per-coroutine state --
+	local Keys = Weak("k")
+
+	-- Helper to get the key of the running coroutine's state
+	local function Key ()
+		local coro = running()
+
+		return Keys[coro] or coro
+	end
+
 	-- Builds the part common to all argument counts
 	local function GetListAndSetter ()
 		local funcs = Weak("k")
 
 		local function setter (func)
 			if func ~= "exists" then
-				funcs[running()] = AssertArg_Pred(IsCallableOrNil, func, "Uncallable function")
+				funcs[Key()] = AssertArg_Pred(IsCallableOrNil, func, "Uncallable function")
 			else
-				return not not funcs[running()]
+				return not not funcs[Key()]
 			end
 		end
 
@@ -59,7 +69,7 @@ do
 		local funcs, setter = GetListAndSetter()
 
 		return function(arg)
-			return (funcs[running()] or NoOp)(arg)
+			return (funcs[Key()] or NoOp)(arg)
 		end, setter
 	end
 
@@ -73,9 +83,20 @@ do
 		local funcs, setter = GetListAndSetter()
 
 		return function(...)
-			return (funcs[running()] or NoOp)(...)
+			return (funcs[Key()] or NoOp)(...)
 		end, setter
 	end
+
+	--- Has the state of functions made by <b>PerCoroutineFunc</b> and its variants be kept,
+	-- for a given coroutine, under another key.<br><br>
+	-- This is meant for bodies that outlive their threads, e.g. when a thread is recycled
+	-- between iterations: with a key that lasts as long as the body, its state carries over
+	-- to the next thread, and the next user of the old thread starts clean.
+	-- @param coro Coroutine.
+	-- @param key Key under which to keep the state; if <b>nil</b>, the coroutine itself.
+	function SetStateKey (coro, key)
+		Keys[coro] = key
+	end
 end
 
 -- Helper to process config info
@@ -39,6 +39,9 @@ local _Map_WithTable_
 -- Cookies --
 local _self = {}
 
+-- Native kernels, unless disabled at boot --
+local Native = UseNativeTableOps ~= false and table_ops_native
+
 ---
 module "table_ops"
 
@@ -779,6 +782,41 @@ do
 	Weak_WithTable = WithBoundTable(Weak)
 end
 
+-- Swap in the native kernels, if available. These have the same semantics, but use raw
+-- access throughout, and presize new tables.
+if Native then
+	-- Helper to build native-backed functions; unless a destination is bound, it is left
+	-- for the native side to create
+	local function WithNative (func)
+		return function(a, b, c, d, e)
+			return func(BoundTableCache("peek") and BoundTableCache("pull"), a, b, c, d, e)
+		end
+	end
+
+	Copy = WithNative(Native.Copy)
+	DeepCopy = WithNative(Native.DeepCopy)
+	GetKeys = WithNative(Native.GetKeys)
+	Invert = WithNative(Native.Invert)
+	MakeSet = WithNative(Native.MakeSet)
+	Map = WithNative(Native.Map)
+	MapKV = WithNative(Native.MapKV)
+	Move = WithNative(Native.Move)
+
+	Copy_WithTable = WithBoundTable(Copy)
+	DeepCopy_WithTable = WithBoundTable(DeepCopy)
+	GetKeys_WithTable = WithBoundTable(GetKeys)
+	Invert_WithTable = WithBoundTable(Invert)
+	MakeSet_WithTable = WithBoundTable(MakeSet)
+	Map_WithTable = WithBoundTable(Map)
+	MapKV_WithTable = WithBoundTable(MapKV)
+	Move_WithTable = WithBoundTable(Move)
+
+	Equal = Native.Equal
+	Filter = Native.Filter
+	Find = Native.Find
+	Reverse = Native.Reverse
+end
+
 -- Cache some routines.
 _Map_ = Map
 _Map_WithTable_ = Map_WithTable
\ No newline at end of file
@@ -22,6 +22,9 @@ local IsTable = var_preds.IsTable
 -- Collect count for code generator --
 local CollectCount = ...
 
+-- Argument assertion elision, as set at boot --
+local ElideArgAsserts = ElideArgAsserts
+
 -- Cached routines --
 local _AssertArg_
 local _WipeRange_
@@ -55,6 +58,13 @@ function AssertArg_Pred (pred, pred_arg, str, arg)
 	return pred_arg
 end
 
+-- In release builds, argument predicates may be elided, leaving only the pass-through.
+if ElideArgAsserts then
+	function AssertArg_Pred (_, pred_arg)
+		return pred_arg
+	end
+end
+
 -- Collect helper --
 local Collect
 
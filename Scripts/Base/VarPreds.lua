@@ -3,6 +3,7 @@
 -- Standard library imports --
 local assert = assert
 local lower = string.lower
+local pairs = pairs
 local rawget = rawget
 local tonumber = tonumber
 local type = type
@@ -10,6 +11,9 @@ local type = type
 -- Pure Lua hacks --
 local debug_getmetatable = debug.getmetatable
 
+-- Native predicates, unless disabled at boot --
+local Native = UseNativeVarPreds ~= false and var_preds_native
+
 -- Cached routines --
 local _HasMeta_
 local _IsCallable_
@@ -483,6 +487,16 @@ TypePair("Thread")
 
 TypePair("Userdata")
 
+-- Swap in the native predicates, if available. These have the same semantics, but skip the
+-- generic closures and conversions.
+if Native then
+	for name, pred in pairs(Native) do
+		assert(_M[name], "Native predicate has no script counterpart")
+
+		_M[name] = pred
+	end
+end
+
 -- Cache some routines.
 _HasMeta_ = HasMeta
 _IsCallable_ = IsCallable
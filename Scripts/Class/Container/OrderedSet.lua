@@ -5,6 +5,8 @@
 -- circular if desired), with its iteration and insertion mechanics, but with unique
 -- non-<b>nil</b> entries which can be checked for membership as in a set.<br><br>
 -- Note that it is not a sorted set. Entries are ordered by how they are added.<br><br>
+-- If the native set has been bound, it is used instead of this one; it has the same
+-- interface, with O(1) membership checks and length.<br><br>
 -- Class.
 module OrderedSet
 ]]
@@ -13,6 +15,11 @@ module OrderedSet
 local assert = assert
 local rawequal = rawequal
 
+-- Prefer the native set, if bound.
+if class.Exists("OrderedSet") then
+	return
+end
+
 -- Unique member keys --
 local _back = {}
 local _front = {}
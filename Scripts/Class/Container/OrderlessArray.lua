@@ -1,7 +1,8 @@
 -- See TacoShell Copyright Notice in main folder of distribution
 
 --[[
----
+--- If the native array has been bound, it is used instead of this one; it has the same
+-- interface, and its iterators stay exact under any removal.<br><br>
 -- Class.
 module OrderlessArray
 ]]
@@ -14,6 +15,11 @@ local pairs = pairs
 local rawequal = rawequal
 local remove = table.remove
 
+-- Prefer the native array, if bound.
+if class.Exists("OrderlessArray") then
+	return
+end
+
 -- Imports --
 local Type = class.Type
 local Weak = table_ops.Weak
@@ -132,6 +138,27 @@ class.Define("OrderlessArray", function(OrderlessArray)
 		end
 	end
 
+	-- Removes every element that satisfies a predicate, in one pass
+	-- pred: Predicate, called as pred(element, index)
+	-- clear: If true, removed elements are not dropped into the extras
+	-- Returns: Count of removed elements
+	----------------------------------------------------------------------
+	function OrderlessArray:RemoveIf (pred, clear)
+		local array = self[_elements]
+		local count = 0
+
+		-- Go back-to-front, so that each element swapped into a vacancy was already kept.
+		for i = #array, 1, -1 do
+			if pred(Map(array[i]), i) then
+				self:Remove(i, clear)
+
+				count = count + 1
+			end
+		end
+
+		return count
+	end
+
 	-- Constructor
 	---------------
 	function OrderlessArray:__cons ()
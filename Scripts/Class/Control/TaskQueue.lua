@@ -11,11 +11,21 @@ module TaskQueue
 
 -- Standard library imports --
 local assert = assert
+local clock = os.clock
 local insert = table.insert
 local ipairs = ipairs
+local max = math.max
+local messagef = messagef
 local newproxy = newproxy
+local next = next
+local remove = table.remove
+local sort = table.sort
 local wrap = coroutine.wrap
 
+-- Native post queues and high-resolution clock, if bound --
+local task_post = task_post
+local timing = timing
+
 -- Modules --
 local coroutine_ex = require("coroutine_ex")
 local func_ops = require("func_ops")
@@ -28,21 +38,49 @@ local var_preds = require("var_preds")
 local Args = iterators.Args
 local AssertArg_Pred = var_ops.AssertArg_Pred
 local Filter = table_ops.Filter
+local GetTimeLapseFunc = func_ops.GetTimeLapseFunc
 local IsCallable = var_preds.IsCallable
+local IsNumber = var_preds.IsNumber
+local IsPositive_Number = var_preds.IsPositive_Number
 local Move_WithTable = table_ops.Move_WithTable
 local Reverse = table_ops.Reverse
+local Weak = table_ops.Weak
 local Try = func_ops.Try
 local Wrap = coroutine_ex.Wrap
 
 -- Unique member keys --
+local _budget = {}
+local _clock = {}
+local _costs = {}
+local _debts = {}
 local _fetch = {}
+local _handlers = {}
 local _is_running = {}
+local _lapse = {}
+local _overruns = {}
+local _post = {}
+local _post_args = {}
+local _post_ids = {}
+local _priorities = {}
+local _scratch = {}
 local _tasks = {}
+local _worst = {}
+
+-- Default clock, in microseconds --
+local function DefaultClock ()
+	return clock() * 1e6
+end
+
+-- Time owed to the running task by frames where it was deferred --
+local Carried = 0
+
+-- Carried time of the tasks whose runs are interrupted by nested runs --
+local CarryStack = {}
 
 -- TaskQueue class definition --
 class.Define("TaskQueue", function(TaskQueue)
 	-- Cache of task batches --
-	local Cache = cache_ops.TableCache()
+	local Cache = cache_ops.TableCache(nil, true)
 
 	-- Task batching helper
 	local function CollectAndValidate (op, ...)
@@ -198,24 +236,209 @@ class.Define("TaskQueue", function(TaskQueue)
 		end
 	end
 
+	--- Binds a native post queue to this queue.<br><br>
+	-- Engine threads post task IDs and integer arguments into the post queue, without
+	-- touching Lua. At the start of each run, everything posted since the last one is
+	-- drained in one batch and added to this queue, ahead of the run.
+	-- @param name Post queue name, as used by <b>task_post</b>; if <b>nil</b>, any binding
+	-- is removed.
+	-- @param handlers Table of handlers, indexed by task ID. A posted task is run as<br><br>
+	-- &nbsp&nbsp&nbsp<i><b>handler(post_arg, arg)</b></i>,<br><br>
+	-- where <i>post_arg</i> is the posted argument and <i>arg</i> is the argument to <b>
+	-- TaskQueue:__call</b>; as with other tasks, it may return <b>"keep"</b>.
+	-- @see TaskQueue:__call
+	function TaskQueue:BindPost (name, handlers)
+		assert(name == nil or task_post, "Post queues unavailable")
+
+		if name ~= nil then
+			task_post.Open(name)
+
+			self[_handlers] = assert(handlers, "Missing handlers")
+			self[_post_args] = {}
+			self[_post_ids] = {}
+		else
+			self[_handlers] = nil
+			self[_post_args] = nil
+			self[_post_ids] = nil
+		end
+
+		self[_post] = name
+	end
+
+	-- Adds any tasks posted to the bound post queue
+	-- The posts have left the native queue by now, so rather than fail partway through, any
+	-- with an unknown task ID are skipped and reported together afterward
+	local function DrainPosts (TQ)
+		local ids, args, count = task_post.Drain(TQ[_post], TQ[_post_ids], TQ[_post_args])
+		local fetch, handlers = TQ[_fetch], TQ[_handlers]
+		local unknown, first
+
+		for i = 1, count do
+			local handler, post_arg = handlers[ids[i]], args[i]
+
+			if handler then
+				fetch[#fetch + 1] = function(arg)
+					return handler(post_arg, arg)
+				end
+			else
+				unknown, first = (unknown or 0) + 1, first or ids[i]
+			end
+		end
+
+		if unknown then
+			messagef("Post queue \"%s\": skipped %d post(s) with unknown task IDs (first: %d)", TQ[_post], unknown, first)
+		end
+	end
+
 	-- Queue visitor
 	local function OnEach (task, arg)
 		return task(arg) == "keep"
 	end
 
+	-- Batch positions, in sorted order, and scratch space to permute the batch into --
+	local Order, SortedTasks, SortedDebts = {}, {}, {}
+
+	-- Priority lookup and batch in sort --
+	local Priorities, Batch
+
+	-- Batch ordering, by position: higher priorities first, and otherwise stable
+	local function PriorityCompare (i, j)
+		local p1, p2 = Priorities[Batch[i]] or 0, Priorities[Batch[j]] or 0
+
+		if p1 ~= p2 then
+			return p1 > p2
+		else
+			return i < j
+		end
+	end
+
+	-- Runs tasks, in priority order, until the budget is spent
+	-- Debts are kept by position, alongside the tasks, so that a task added more than once
+	-- is owed time separately for each entry
+	local function RunBudgeted (TQ, arg)
+		local tasks, kept = TQ[_tasks], TQ[_scratch]
+		local costs, debts = TQ[_costs], TQ[_debts]
+		local budget, now = TQ[_budget], TQ[_clock]
+		local n = #tasks
+
+		-- Put the batch in priority order, moving the debts along with it.
+		if next(TQ[_priorities]) then
+			for i = 1, n do
+				Order[i] = i
+			end
+
+			Priorities, Batch = TQ[_priorities], tasks
+
+			sort(Order, PriorityCompare)
+
+			Priorities, Batch = nil
+
+			for i = 1, n do
+				SortedTasks[i], SortedDebts[i] = tasks[Order[i]], debts[Order[i]] or 0
+			end
+
+			for i = 1, n do
+				tasks[i], debts[i] = SortedTasks[i], SortedDebts[i]
+				Order[i], SortedTasks[i], SortedDebts[i] = nil
+			end
+		end
+
+		-- Run tasks while the budget allows, timing each one. At least one task is run,
+		-- so the queue always makes progress.
+		local start = now()
+		local t1, ran = start, 0
+
+		while ran < n and (ran == 0 or t1 - start < budget) do
+			ran = ran + 1
+
+			local task = tasks[ran]
+
+			Carried, debts[ran] = debts[ran] or 0
+
+			local t0 = t1
+			local keep = task(arg) == "keep"
+
+			Carried, t1 = 0, now()
+
+			local cost = costs[task]
+
+			if not cost then
+				cost = { count = 0, total = 0 }
+
+				costs[task] = cost
+			end
+
+			cost.count = cost.count + 1
+			cost.total = cost.total + t1 - t0
+
+			if keep then
+				kept[#kept + 1] = task
+			end
+		end
+
+		-- Log any overrun.
+		local elapsed = t1 - start
+
+		if elapsed > budget then
+			TQ[_overruns] = TQ[_overruns] + 1
+			TQ[_worst] = max(TQ[_worst], elapsed - budget)
+		end
+
+		-- Carry over unfinished work, ahead of the tasks that ran, and credit it with this
+		-- frame's time so that it does not fall behind.
+		local lapse = TQ[_lapse]()
+
+		for i = ran + 1, n do
+			tasks[i - ran], debts[i - ran] = tasks[i], (debts[i] or 0) + lapse
+		end
+
+		local nkept = #kept
+
+		for i = 1, nkept do
+			tasks[n - ran + i], debts[n - ran + i] = kept[i]
+			kept[i] = nil
+		end
+
+		for i = n, n - ran + nkept + 1, -1 do
+			tasks[i], debts[i] = nil
+		end
+	end
+
 	-- Protected run
+	-- Any time carried by a task running this queue is set aside until the run is done
 	local function Run (TQ, arg)
 		TQ[_is_running] = true
 
-		-- Fetch recently added tasks.
+		CarryStack[#CarryStack + 1], Carried = Carried, 0
+
+		-- Fetch any posted tasks, then all recently added tasks.
+		if TQ[_post] then
+			DrainPosts(TQ)
+		end
+
 		Move_WithTable(TQ[_tasks], TQ[_fetch], "append")
 
 		-- Run the tasks; keep ones returning a valid result.
-		Filter(TQ[_tasks], OnEach, arg, true)
+		if TQ[_budget] then
+			RunBudgeted(TQ, arg)
+		else
+			Filter(TQ[_tasks], OnEach, arg, true)
+		end
 	end
 
 	-- Run cleanup
+	-- If a task threw, its debt must not leak into later lapses, and the tasks kept so far
+	-- are still in place in the batch, so the scratch list is dropped; either way, the time
+	-- carried by any outer task is given back
 	local function RunDone (TQ)
+		local kept = TQ[_scratch]
+
+		for i = #kept, 1, -1 do
+			kept[i] = nil
+		end
+
+		Carried = remove(CarryStack) or 0
+
 		TQ[_is_running] = false
 	end
 
@@ -230,10 +453,93 @@ class.Define("TaskQueue", function(TaskQueue)
 		Try(Run, RunDone, self, arg)
 	end
 
+	--- Gets time owed to the running task, i.e. time that passed during frames when a
+	-- budgeted queue deferred it.<br><br>
+	-- Time-based tasks should add this to their time lapse, to stay in step.
+	-- @return Carried time lapse, or 0 outside of budgeted runs.
+	-- @see TaskQueue:SetBudget
+	-- @see TaskQueue.TakeCarriedLapse
+	function TaskQueue.GetCarriedLapse ()
+		return Carried
+	end
+
+	--- Variant of <b>TaskQueue.GetCarriedLapse</b> that also clears the time owed, so that a
+	-- task which samples its lapse more than once is only credited once.
+	-- @return Carried time lapse, or 0 outside of budgeted runs or once taken.
+	-- @see TaskQueue.GetCarriedLapse
+	function TaskQueue.TakeCarriedLapse ()
+		local carried = Carried
+
+		Carried = 0
+
+		return carried
+	end
+
+	--- Gets the budget statistics gathered so far.
+	-- @return Count of runs that went over budget.
+	-- @return Worst overrun, in microseconds.
+	-- @see TaskQueue:GetTaskCost
+	-- @see TaskQueue:SetBudget
+	function TaskQueue:GetBudgetStats ()
+		return self[_overruns], self[_worst]
+	end
+
+	--- Gets the measured cost of a task, during budgeted runs.
+	-- @param task Task, as added to the queue.
+	-- @return Average cost per call, in microseconds, or <b>nil</b> if never measured.
+	-- @return Count of calls measured.
+	-- @see TaskQueue:SetBudget
+	function TaskQueue:GetTaskCost (task)
+		local cost = self[_costs][task]
+
+		if cost then
+			return cost.total / cost.count, cost.count
+		end
+
+		return nil, 0
+	end
+
+	--- Puts the queue in budgeted mode, or takes it out.<br><br>
+	-- In budgeted mode, each run processes tasks in priority order, stopping once the
+	-- budget is spent (at least one task is always run). Tasks that are not reached are
+	-- carried over to the front of the next run, and owed the time that passed; see <b>
+	-- TaskQueue.GetCarriedLapse</b>. Each task is timed, and runs that go over budget are
+	-- counted.
+	-- @param budget Time budget per run, in microseconds, or <b>nil</b> to run every task
+	-- each time.
+	-- @param now Optional clock function, returning the time in microseconds. If absent,
+	-- the high-resolution clock is used when available.
+	-- @see TaskQueue:GetBudgetStats
+	-- @see TaskQueue:GetTaskCost
+	-- @see TaskQueue:SetPriority
+	function TaskQueue:SetBudget (budget, now)
+		assert(budget == nil or IsPositive_Number(budget), "Invalid budget")
+		assert(not self[_is_running], "Budget change forbidden during run")
+
+		self[_budget] = budget
+		self[_clock] = now or (timing and timing.Microseconds) or DefaultClock
+		self[_debts] = {}
+		self[_lapse] = GetTimeLapseFunc("tasks")
+		self[_overruns] = 0
+		self[_worst] = 0
+	end
+
+	--- Sets a task's priority, for use in budgeted runs.
+	-- @param task Task, as added to the queue.
+	-- @param priority Priority to assign, or <b>nil</b> for the default of 0. Higher
+	-- priorities run first.
+	-- @see TaskQueue:SetBudget
+	function TaskQueue:SetPriority (task, priority)
+		assert(priority == nil or IsNumber(priority), "Invalid priority")
+
+		self[_priorities][task] = priority
+	end
+
 	--- Removes all tasks in the queue.
 	function TaskQueue:Clear ()
 		assert(not self[_is_running], "Clear forbidden during run")
 
+		self[_debts] = {}
 		self[_fetch] = {}
 		self[_tasks] = {}
 	end
@@ -260,6 +566,10 @@ class.Define("TaskQueue", function(TaskQueue)
 
 	--- Class constructor.
 	function TaskQueue:__cons ()
+		self[_costs] = Weak("k")
+		self[_priorities] = Weak("k")
+		self[_scratch] = {}
+
 		self:Clear()
 	end
 end)
\ No newline at end of file
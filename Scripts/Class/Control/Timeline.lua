@@ -10,8 +10,8 @@ module Timeline
 
 -- Standard library imports --
 local assert = assert
-local insert = table.insert
 local ipairs = ipairs
+local setmetatable = setmetatable
 local sort = table.sort
 
 -- Modules --
@@ -25,15 +25,98 @@ local AssertArg_Pred = var_ops.AssertArg_Pred
 local DeepCopy = table_ops.DeepCopy
 local IsCallable = var_preds.IsCallable
 local IsNonNegative_Number = var_preds.IsNonNegative_Number
-local Move_WithTable = table_ops.Move_WithTable
+local IsPositive_Number = var_preds.IsPositive_Number
+local New = class.New
 local Try = func_ops.Try
 
 -- Unique member keys --
+local _due = {}
 local _events = {}
 local _fetch = {}
+local _goto_count = {}
+local _granularity = {}
 local _is_updating = {}
-local _queue = {}
 local _time = {}
+local _wheel = {}
+
+-- Default time covered by one wheel bucket --
+local DefaultGranularity = 1 / 30
+
+-- Use the native timer wheel? --
+local UseWheel = UseNativeTimerWheel ~= false and class.Exists("TimerWheel")
+
+-- Sorted list stand-in for the timer wheel, with the same interface --
+local EventList = {}
+
+EventList.__index = EventList
+
+-- Returns: If true, entry1 comes before entry2
+local function EntryCompare (entry1, entry2)
+	return entry1.when < entry2.when or (entry1.when == entry2.when and entry1.id < entry2.id)
+end
+
+-- Schedules an entry; the list is re-sorted on the next gather
+function EventList:Add (when, id)
+	self[#self + 1] = { when = when, id = id }
+
+	self.is_sorted = false
+end
+
+-- Removes all entries
+function EventList:Clear ()
+	for i = #self, 1, -1 do
+		self[i] = nil
+	end
+
+	self.is_sorted = true
+end
+
+-- Gets the IDs of the entries in [from, to), ordered by time and then by ID
+function EventList:Gather (from, to, out)
+	if not self.is_sorted then
+		sort(self, EntryCompare)
+
+		self.is_sorted = true
+	end
+
+	-- Find the first entry at or after the range start, then collect until the end.
+	local lo, hi = 1, #self + 1
+
+	while lo < hi do
+		local mid = lo + (hi - lo - (hi - lo) % 2) / 2
+
+		if self[mid].when < from then
+			lo = mid + 1
+		else
+			hi = mid
+		end
+	end
+
+	local count = 0
+
+	for i = lo, #self do
+		local entry = self[i]
+
+		if entry.when >= to then
+			break
+		end
+
+		count = count + 1
+
+		out[count] = entry.id
+	end
+
+	return out, count
+end
+
+-- Makes a timer wheel, or a list if the native wheel is not in use
+local function NewWheel (granularity)
+	if UseWheel then
+		return New("TimerWheel", granularity)
+	else
+		return setmetatable({ is_sorted = true }, EventList)
+	end
+end
 
 -- Timeline class definition --
 class.Define("Timeline", function(Timeline)
@@ -51,28 +134,16 @@ class.Define("Timeline", function(Timeline)
 		event_to_add.when = AssertArg_Pred(IsNonNegative_Number, when, "Invalid time")
 		event_to_add.event = AssertArg_Pred(IsCallable, event, "Uncallable event")
 
-		insert(self[_fetch], event_to_add)
+		self[_fetch][#self[_fetch] + 1] = event_to_add
 	end
 
-	-- Returns: If true, event1 is later than event2
-	local function EventCompare (event1, event2)
-		return event1.when > event2.when
-	end
-
-	-- Enqueues future events
-	local function BuildQueue (T)
-		local begin = T[_time]
-		local queue = {}
+	-- Schedules an event in the wheel, under its index in the event list
+	local function Schedule (T, event)
+		local events = T[_events]
 
-		for i, event in ipairs(T[_events]) do
-			if event.when < begin then
-				break
-			end
-
-			queue[i] = event
-		end
+		events[#events + 1] = event
 
-		T[_queue] = queue
+		T[_wheel]:Add(event.when, #events)
 	end
 
 	-- Protected update
@@ -80,38 +151,41 @@ class.Define("Timeline", function(Timeline)
 		T[_is_updating] = true
 
 		-- Merge in any new events.
-		if #T[_fetch] > 0 then
-			sort(Move_WithTable(T[_events], T[_fetch], "append"), EventCompare)
+		local fetch = T[_fetch]
 
-			-- Rebuild the queue with the new events.
-			BuildQueue(T)
-		end
+		for i = 1, #fetch do
+			Schedule(T, fetch[i])
 
-		-- Issue all events, in order. The queue is reacquired on each pass, since events
-		-- may rebuild it via gotos.
-		while true do
-			local after = T[_time] + step
-			local queue = T[_queue]
+			fetch[i] = nil
+		end
 
-			-- Acquire the next event. If there is none or it comes too late, quit.
-			local event = queue[#queue]
+		-- Issue all events, in order. Only the wheel buckets under the step are visited.
+		-- If an event moves the time via a goto, the remainder of the step is gathered
+		-- again from the new time.
+		local events = T[_events]
 
-			if not event or event.when >= after then
-				break
-			end
+		repeat
+			local after = T[_time] + step
+			local due, count = T[_wheel]:Gather(T[_time], after, T[_due])
+			local goto_count = T[_goto_count]
 
-			local when = event.when
+			for i = 1, count do
+				local event = events[due[i]]
+				local when = event.when
 
-			-- Advance the time to the event and diminish the time step.
-			T[_time] = when
+				-- Advance the time to the event and diminish the time step.
+				T[_time] = when
 
-			step = after - when
+				step = after - when
 
-			-- Issue the event and move on to the next one.
-			event.func(when, arg)
+				-- Issue the event. Abandon the rest of the batch if it did a goto.
+				event.event(when, arg)
 
-			queue[#queue] = nil
-		end
+				if T[_goto_count] ~= goto_count then
+					break
+				end
+			end
+		until T[_goto_count] == goto_count
 
 		-- Issue the final time advancement.
 		T[_time] = T[_time] + step
@@ -127,7 +201,7 @@ class.Define("Timeline", function(Timeline)
 	-- Before the update, any events in the fetch list are first merged into the event
 	-- list.<br><br>
 	-- If an event calls <b>Timeline:GoTo</b> on this timeline, updating will resume
-	-- at the new time and 
+	-- at the new time and continue with what remains of the step.
 	-- @param step Time step.
 	-- @param arg Argument to event functions.
 	-- @see Timeline:GoTo
@@ -144,7 +218,8 @@ class.Define("Timeline", function(Timeline)
 
 		self[_events] = {}
 		self[_fetch] = {}
-		self[_queue] = {}
+
+		self[_wheel]:Clear()
 	end
 
 	---
@@ -153,13 +228,14 @@ class.Define("Timeline", function(Timeline)
 		return self[_time]
 	end
 
-	--- Sets the timeline to a given time.
+	--- Sets the timeline to a given time.<br><br>
+	-- Events are kept after they go off, so moving the time backward will cause them to
+	-- be issued again. Only the time is updated; no events are reordered.
 	-- @param when Time to assign.
 	-- @see Timeline:GetTime
 	function Timeline:GoTo (when)
 		self[_time] = AssertArg_Pred(IsNonNegative_Number, when, "Invalid time")
-
-		BuildQueue(self)
+		self[_goto_count] = self[_goto_count] + 1
 	end
 
 	--- Metamethod.
@@ -169,19 +245,35 @@ class.Define("Timeline", function(Timeline)
 	end
 
 	--- Class constructor.
-	function Timeline:__cons ()
+	-- @param granularity Optional time covered by each bucket of the timeline's timer
+	-- wheel; events are gathered a bucket at a time, so this should be on the order of
+	-- the time step. If absent, a default is used. Ignored if the timeline falls back to
+	-- a sorted event list (see <b>UseNativeTimerWheel</b>).
+	function Timeline:__cons (granularity)
+		assert(granularity == nil or IsPositive_Number(granularity), "Invalid granularity")
+
+		self[_due] = {}
+		self[_goto_count] = 0
+		self[_granularity] = granularity or DefaultGranularity
 		self[_time] = 0
+		self[_wheel] = NewWheel(self[_granularity])
 
 		self:Clear()
 	end
 
 	--- Class clone body.
 	function Timeline:__clone (T)
-		self[_events] = DeepCopy(T[_events])
+		self[_due] = {}
+		self[_events] = {}
 		self[_fetch] = DeepCopy(T[_fetch])
+		self[_goto_count] = 0
+		self[_granularity] = T[_granularity]
 		self[_is_updating] = T[_is_updating]
 		self[_time] = T[_time]
+		self[_wheel] = NewWheel(T[_granularity])
 
-		BuildQueue(self)
+		for _, event in ipairs(DeepCopy(T[_events])) do
+			Schedule(self, event)
+		end
 	end
 end)
\ No newline at end of file
@@ -10,6 +10,7 @@ module Timer
 -- Standard library imports --
 local assert = assert
 local modf = math.modf
+local select = select
 
 -- Modules --
 local func_ops = require("func_ops")
@@ -21,13 +22,38 @@ local IsPositive_Number = var_preds.IsPositive_Number
 local NoOp = func_ops.NoOp
 
 -- Unique member keys --
+local _bank = {}
 local _counter = {}
 local _duration = {}
 local _is_paused = {}
 local _offset = {}
+local _slot = {}
 
 -- Timer class definition --
 class.Define("Timer", function(Timer)
+	-- Gets the timer state, either from members or from the bank
+	local function GetState (T)
+		local bank = T[_bank]
+
+		if bank then
+			return bank:Get(T[_slot])
+		else
+			return T[_duration], T[_counter], T[_offset], T[_is_paused]
+		end
+	end
+
+	-- Sets the timer state, either in members or in the bank; a timer that was never started
+	-- has no counter or offset yet, which the bank takes as 0
+	local function SetState (T, duration, counter, offset, is_paused)
+		local bank = T[_bank]
+
+		if bank then
+			bank:Set(T[_slot], duration, counter or 0, offset or 0, is_paused)
+		else
+			T[_duration], T[_counter], T[_offset], T[_is_paused] = duration, counter, offset, is_paused
+		end
+	end
+
 	--- Checks the timer for timeouts.<br><br>
 	-- The counter is divided by the timeout duration. The integer part of this is the
 	-- timeout count, and the fraction is the new counter. If the count is greater than
@@ -41,6 +67,12 @@ class.Define("Timer", function(Timer)
 	-- @return Timeout count, or 0 if the timer is stopped.
 	-- @see Timer:Update
 	function Timer:Check (how)
+		local bank = self[_bank]
+
+		if bank then
+			return bank:CheckSlot(self[_slot], how)
+		end
+
 		local count = 0
 		local duration = self[_duration]
 		local slice
@@ -75,23 +107,32 @@ class.Define("Timer", function(Timer)
 	-- @see Timer:SetCounter
 	-- @see Timer:Update
 	function Timer:GetCounter (is_fraction)
-		local duration = self[_duration]
-		local counter
+		local bank = self[_bank]
 
-		if duration then
-			counter = self[_counter]
+		if bank then
+			return bank:GetCounter(self[_slot], is_fraction)
+		end
 
+		local duration, counter = self[_duration], self[_counter]
+
+		if duration then
 			if is_fraction then
 				counter = counter / duration
 			end
 		end
 
-		return counter or 0
+		return duration and counter or 0
 	end
 
 	---
 	-- @return Timeout duration, or <b>nil</b> if the timer is stopped. 
 	function Timer:GetDuration ()
+		local bank = self[_bank]
+
+		if bank then
+			return bank:GetDuration(self[_slot])
+		end
+
 		return self[_duration]
 	end
 
@@ -99,7 +140,9 @@ class.Define("Timer", function(Timer)
 	-- @return If true, the timer is paused.
 	-- @see Timer:SetPause
 	function Timer:IsPaused ()
-		return self[_is_paused]
+		local _, _, _, is_paused = GetState(self)
+
+		return is_paused
 	end
 
 	--- Sets the counter directly.<br><br>
@@ -111,21 +154,35 @@ class.Define("Timer", function(Timer)
 	function Timer:SetCounter (counter, is_fraction)
 		assert(IsNonNegative_Number(counter), "Invalid counter")
 
-		local duration = assert(self[_duration], "Timer not running")
+		local bank = self[_bank]
 
-		if is_fraction then
-			counter = counter * duration
-		end
+		if bank then
+			assert(bank:SetCounter(self[_slot], counter, is_fraction), "Timer not running")
+
+		else
+			local duration = self[_duration]
+
+			assert(duration, "Timer not running")
+
+			if is_fraction then
+				counter = counter * duration
+			end
 
-		self[_counter] = counter
-		self[_offset] = counter % duration
+			self[_counter], self[_offset] = counter, counter % duration
+		end
 	end
 
 	--- Pauses or resumes the timer.
 	-- @param pause If true, pause the timer.
 	-- @see Timer:IsPaused
 	function Timer:SetPause (pause)
-		self[_is_paused] = not not pause
+		local bank = self[_bank]
+
+		if bank then
+			bank:SetPause(self[_slot], pause)
+		else
+			self[_is_paused] = not not pause
+		end
 	end
 
 	--- Starts the timer.
@@ -136,16 +193,27 @@ class.Define("Timer", function(Timer)
 		assert(IsPositive_Number(duration), "Invalid duration")
 		assert(t == nil or IsNonNegative_Number(t), "Invalid start time")
 
-		self[_duration] = duration
-		self[_is_paused] = false
+		t = t or 0
 
-		self:SetCounter(t or 0)
+		local bank = self[_bank]
+
+		if bank then
+			bank:Start(self[_slot], duration, t)
+		else
+			self[_duration], self[_counter], self[_offset], self[_is_paused] = duration, t, t % duration, false
+		end
 	end
 
 	--- Stops the timer.
 	-- @see Timer:Start
 	function Timer:Stop ()
-		self[_duration] = nil
+		local bank = self[_bank]
+
+		if bank then
+			bank:Stop(self[_slot])
+		else
+			self[_duration] = nil
+		end
 	end
 
 	--- Advances the counter.<br><br>
@@ -154,7 +222,12 @@ class.Define("Timer", function(Timer)
 	-- @see Timer:Check
 	-- @see Timer:GetCounter
 	function Timer:Update (step)
-		if self[_duration] and not self[_is_paused] then
+		local bank = self[_bank]
+
+		if bank then
+			bank:UpdateSlot(self[_slot], step)
+
+		elseif self[_duration] and not self[_is_paused] then
 			self[_counter] = self[_counter] + step
 		end
 	end
@@ -196,12 +269,11 @@ class.Define("Timer", function(Timer)
 
 		-- Setup --
 		function(T, with_final)
-			duration = T[_duration]
+			duration = T:GetDuration()
 
 			if duration then
 				count = T:Check("continue")
-				counter = T[_counter]
-				offset = T[_offset]
+				counter, offset = select(2, GetState(T))
 				tally = 0
 				total = count * duration + counter - offset
 
@@ -217,17 +289,69 @@ class.Define("Timer", function(Timer)
 		NoOp
 	end)
 
+	--- Gets the timer's place in its bank, e.g. to match it with the results of a batch
+	-- <b>TimerBank:Check</b>.
+	-- @return Bank and slot, or <b>nil</b> if the timer is not in a bank.
+	-- @see Timer:__cons
+	function Timer:GetBankSlot ()
+		return self[_bank], self[_slot]
+	end
+
+	--- Moves the timer's state into a bank, or out of one, keeping it intact.<br><br>
+	-- Any slot held in the old bank is released.
+	-- @param bank <b>TimerBank</b> to hold the state, or <b>nil</b> to keep it in the
+	-- timer's own members.
+	-- @see Timer:__cons
+	function Timer:SetBank (bank)
+		if bank ~= self[_bank] then
+			local duration, counter, offset, is_paused = GetState(self)
+
+			if self[_bank] then
+				self[_bank]:Free(self[_slot])
+			end
+
+			self[_bank], self[_slot] = bank, bank and bank:Alloc()
+
+			SetState(self, duration, counter, offset, is_paused)
+		end
+	end
+
 	--- Class constructor.<br><br>
 	-- The timer begins as stopped and unpaused.
-	function Timer:__cons ()
-		self[_is_paused] = false
+	-- @param bank Optional <b>TimerBank</b>. If present, the timer's state is kept in a
+	-- slot in the bank, and the timer acts as a view on it, so that all timers in the bank
+	-- can be updated and checked at once. The slot is released when the timer is collected,
+	-- or moved to another bank.
+	-- @see Timer:SetBank
+	function Timer:__cons (bank)
+		if bank then
+			self[_bank] = bank
+			self[_slot] = bank:Alloc()
+		else
+			self[_is_paused] = false
+		end
 	end
 
 	--- Class clone body.
-	function Timer:__clone (T)
-		self[_counter] = T[_counter]
-		self[_duration] = T[_duration]
-		self[_is_paused] = T[_is_paused]
-		self[_offset] = T[_offset]
+	-- @param bank Optional <b>TimerBank</b> to hold the clone's state, as per <b>
+	-- Timer:__cons</b>. A clone is not put in its original's bank unless asked, since a
+	-- bank update advances every timer in it.
+	function Timer:__clone (T, bank)
+		if bank then
+			self[_bank] = bank
+			self[_slot] = bank:Alloc()
+		end
+
+		SetState(self, GetState(T))
+	end
+
+	--- Metamethod.<br><br>
+	-- Releases the timer's bank slot, if it has one.
+	function Timer:__gc ()
+		local bank = self[_bank]
+
+		if bank then
+			bank:Free(self[_slot])
+		end
 	end
 end)
\ No newline at end of file
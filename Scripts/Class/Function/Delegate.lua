@@ -14,6 +14,7 @@ module Delegate
 -- Standard library imports --
 local ipairs = ipairs
 local remove = table.remove
+local running = coroutine.running
 
 -- Modules --
 local table_ops = require("table_ops")
@@ -26,6 +27,9 @@ local CollectArgsInto = var_ops.CollectArgsInto
 local Copy = table_ops.Copy
 local IsCallableOrNil = var_preds.IsCallableOrNil
 
+-- Native call chain, unless disabled at boot --
+local DelegateOps = UseNativeDelegates ~= false and delegate_ops
+
 -- Unique member keys --
 local _afters = {}
 local _befores = {}
@@ -56,7 +60,7 @@ class.Define("Delegate", function(Delegate)
 	end
 
 	-- Cache of core results tables --
-	local ResultsCache = cache_ops.TableCache("unpack_and_wipe")
+	local ResultsCache = cache_ops.TableCache("unpack_and_wipe", true)
 
 	--- Metamethod.<br><br>
 	-- If no core is present, this is a no-op.<br><br>
@@ -66,7 +70,8 @@ class.Define("Delegate", function(Delegate)
 	-- The core is then called with the call arguments.<br><br>
 	-- If any "after" functions have been added, these are called, in least- to most-
 	-- recent order, with the call arguments.<br><br>
-	-- Finally, the results of the core call are returned.
+	-- Finally, the results of the core call are returned.<br><br>
+	-- Any of these functions may yield, when the delegate is called from a coroutine.
 	-- @param ... Arguments to call.
 	-- @return Call results.
 	-- @see Delegate:AddAfter
@@ -77,10 +82,19 @@ class.Define("Delegate", function(Delegate)
 		local core = self[_core]
 
 		if core then
-			-- Invoke each before routine, aborting if requested.
 			local befores = self[_befores]
 			local can_abort = self[_can_abort]
 
+			-- If available, run the whole chain natively, which keeps the core's results on
+			-- the stack while the after routines run. This is skipped inside coroutines, since
+			-- yields cannot cross the native call, and without advice, when the core can just
+			-- be tail-called.
+			if DelegateOps and (#befores > 0 or #self[_afters] > 0) and not running() then
+				return DelegateOps.Invoke(core, befores, self[_afters], can_abort, ...)
+			end
+
+			-- Invoke each before routine, aborting if requested.
+
 			for i = #befores, 1, -1 do
 				if befores[i](...) == "abort" and can_abort then
 					return
@@ -17,6 +17,7 @@ local assert = assert
 local insert = table.insert
 local ipairs = ipairs
 local remove = table.remove
+local select = select
 
 -- Modules --
 local cache_ops = require("cache_ops")
@@ -37,6 +38,7 @@ local WipeRange = var_ops.WipeRange
 
 -- Unique member keys --
 local _args_cache = {}
+local _dispatch = {}
 local _funcs = {}
 local _key = {}
 local _last = {}
@@ -45,28 +47,20 @@ local _paramc = {}
 -- Multimethod class definition --
 class.Define("Multimethod", function(Multimethod)
 	-- Cache of function list tables --
-	local FuncsCache = TableCache()
+	local FuncsCache = TableCache(nil, true)
 
-	--- Metamethod.<br><br>
-	-- The arguments are checked against the multimethod's specializations, up to the
-	-- dispatch-relevant parameter count. From the pool of functions that will successfully
-	-- fit the arguments, the ones that most completely match the first argument are chosen.
-	-- From those in turn, the ones that best match the second argument are chosen, and so
-	-- on until one function remains, which is then called.<br><br>
-	-- If no function matches the arguments, an error is thrown.
-	-- @param ... Call arguments.
-	-- @return Call results.
-	function Multimethod:__call (...)
+	-- Resolves the function that best matches a set of arguments
+	local function Resolve (M, ...)
 		local funcs = FuncsCache("pull")
-		local source = self[_funcs]
+		local source = M[_funcs]
 
 		-- Gather the arguments.
-		local args_cache = self[_args_cache]
+		local args_cache = M[_args_cache]
 		local argc, args = CollectArgsInto(args_cache("pull"), ...)
 
 		-- Winnow out inapplicable functions: Untyped parameters permit any value; arguments
 		-- must be of / derived from the parameter type otherwise.
-		for i = 1, self[_paramc] do
+		for i = 1, M[_paramc] do
 			local arg = args[i]
 			local atype, is_instance = Type(arg)
 			local count = 0
@@ -165,7 +159,60 @@ class.Define("Multimethod", function(Multimethod)
 		args_cache(args, 1, argc)
 		FuncsCache(funcs)
 
-		-- Save and invoke the remaining function.
+		return func
+	end
+
+	--- Metamethod.<br><br>
+	-- The arguments are checked against the multimethod's specializations, up to the
+	-- dispatch-relevant parameter count. From the pool of functions that will successfully
+	-- fit the arguments, the ones that most completely match the first argument are chosen.
+	-- From those in turn, the ones that best match the second argument are chosen, and so
+	-- on until one function remains, which is then called.<br><br>
+	-- The chosen function is remembered against the tuple of argument types, so later calls
+	-- with the same types go straight to it. The memo is discarded by <b>Define</b>.<br><br>
+	-- If no function matches the arguments, an error is thrown.
+	-- @param ... Call arguments.
+	-- @return Call results.
+	function Multimethod:__call (...)
+		local paramc = self[_paramc]
+
+		-- Walk the dispatch memo along the argument types. Each level is keyed by the type
+		-- of one argument, with the function itself stored at the last level.
+		local node = self[_dispatch]
+
+		for i = 1, paramc - 1 do
+			node = node[Type((select(i, ...)))]
+
+			if not node then
+				break
+			end
+		end
+
+		local ltype = Type((select(paramc, ...)))
+		local func = node and node[ltype]
+
+		-- On a miss, resolve the function the long way and memoize it, filling in any
+		-- missing levels.
+		if not func then
+			func, node = Resolve(self, ...), self[_dispatch]
+
+			for i = 1, paramc - 1 do
+				local atype = Type((select(i, ...)))
+				local next = node[atype]
+
+				if not next then
+					next = {}
+
+					node[atype] = next
+				end
+
+				node = next
+			end
+
+			node[ltype] = func
+		end
+
+		-- Save and invoke the function.
 		self[_last] = func
 
 		return func(...)
@@ -189,6 +236,9 @@ class.Define("Multimethod", function(Multimethod)
 
 		assert(count <= self[_paramc])
 
+		-- Any memoized dispatch may now be stale.
+		self[_dispatch] = {}
+
 		for _, entry in ipairs(self[_funcs]) do
 			local index = 0
 
@@ -237,7 +287,10 @@ class.Define("Multimethod", function(Multimethod)
 		SuperCons(self, "Sealable")
 
 		-- Argument table cache --
-		self[_args_cache] = TableCache("wipe_range")
+		self[_args_cache] = TableCache("wipe_range", true)
+
+		-- Memoized dispatch, keyed by argument types --
+		self[_dispatch] = {}
 
 		-- Function definitions --
 		self[_funcs] = {}
@@ -4,18 +4,27 @@
 --- A variable family provides a minimal database for variables, with special support
 -- for various types. In addition, a family has several "tiers" of these variables to
 -- allow rollback if the current set should become invalid.<br><br>
+-- When the native variable store is bound, bools and numbers may also be addressed by the
+-- integer IDs from <b>var_store.Intern</b>. A number that is a valid ID is taken as one;
+-- any other number is a name, though one that may later be read as an ID, once that many
+-- names have been interned, so numeric names are best avoided.<br><br>
 -- Class.
 module VarFamily
 ]]
 
 -- Standard library imports --
 local assert = assert
+local floor = math.floor
+local getmetatable = getmetatable
 local ipairs = ipairs
 local max = math.max
 local min = math.min
+local next = next
 local pairs = pairs
+local rawequal = rawequal
 local rawget = rawget
 local setmetatable = setmetatable
+local type = type
 
 -- Modules --
 local bit = require("bit")
@@ -33,12 +42,27 @@ local bor = bit.bor
 local lshift = bit.lshift
 local rshift = bit.rshift
 
+-- Native typed store, unless disabled at boot --
+local Native = UseNativeVarStore ~= false and var_store
+
+-- Keep working set timers in a native bank, unless disabled at boot? --
+local UseTimerBank = UseNativeTimerBank ~= false and class.Exists("TimerBank")
+
 -- Unique member keys --
 local _auto_propagate = {}
+local _dirty = {}
+local _dirty_spare = {}
 local _fetch = {}
 local _groups = {}
 local _is_updating = {}
+local _journal = {}
+local _journal_epoch = {}
+local _journal_limits = {}
+local _journal_size = {}
+local _proxies = {}
 local _tier_count = {}
+local _timer_bank = {}
+local _watches = {}
 
 -- Cookies --
 local _set_name = {}
@@ -48,18 +72,26 @@ class.Define("VarFamily", function(VarFamily)
 	-- Lookup metatables --
 	local Metas = {}
 
+	-- Scratch array for names off native dirty lists --
+	local DirtyNames = {}
+
 	-- Variable lookup builder
-	local function MakeMeta (what, def, is_prim)
+	local function MakeMeta (what, def, is_prim, has_native)
 		local meta
 
 		if is_prim then
-			meta = { __index = def, is_prim = true }
+			meta = { __index = def, is_prim = true, is_native = not not (Native and has_native) }
+
+			-- Primitive working sets are overlays, which bring their own metatables.
+			function meta:set_current (VF, group_cur)
+				VF[self] = group_cur
+			end
 		else
 			meta = lazy_ops.MakeOnDemand_Meta(def)
-		end
 
-		function meta:set_current (VF, group_cur)
-			VF[self] = setmetatable(group_cur, self)
+			function meta:set_current (VF, group_cur)
+				VF[self] = setmetatable(group_cur, self)
+			end
 		end
 
 		Metas[what] = meta
@@ -84,14 +116,304 @@ class.Define("VarFamily", function(VarFamily)
 
 	-- Helper to establish working set of variables
 	local function SetupWorkingSet (VF)
+		local proxies = VF[_proxies]
+
 		for what, group in pairs(VF[_groups]) do
-			Metas[what]:set_current(VF, group[1])
+			Metas[what]:set_current(VF, proxies and proxies[what] or group[1])
+		end
+	end
+
+	-- Primitive groups keep their tiers copy-on-write. Tiers above the first are snapshots,
+	-- which may be shared by several tiers. The working set is an overlay on a base snapshot,
+	-- holding only the variables changed since the last promotion or rollback, along with
+	-- a set of cleared variables. Promotion and rollback then cost O(changed variables).
+
+	-- Copies a primitive snapshot
+	local function CopySnapshot (snapshot, meta)
+		return setmetatable(table_ops.Copy(snapshot), meta)
+	end
+
+	-- Builds copy-on-write tiers for a primitive group; native groups use a store per tier
+	local function NewTiers (what, meta, tier_count)
+		if meta.is_native then
+			local tiers = {}
+
+			for i = 1, tier_count do
+				tiers[i] = Native.New(what)
+			end
+
+			return tiers
+		end
+
+		local snapshot = setmetatable({}, meta)
+		local tiers = { setmetatable({}, { __index = snapshot, base = snapshot, def = meta.__index }) }
+
+		for i = 2, tier_count do
+			tiers[i] = snapshot
+		end
+
+		return tiers
+	end
+
+	-- Points a working set at a new base, dropping its changes
+	local function Rebase (overlay, base)
+		local state = getmetatable(overlay)
+
+		for k in pairs(overlay) do
+			overlay[k] = nil
+		end
+
+		state.__index, state.base, state.cleared = base, base, nil
+	end
+
+	-- Clears a primitive variable in a working set
+	local function Clear (overlay, name)
+		local state = getmetatable(overlay)
+
+		overlay[name] = nil
+
+		-- Journaled working sets are proxies, which log the write and forward it back here;
+		-- native stores unset the variable themselves.
+		if state.is_proxy or state.base == nil then
+			return
+		end
+
+		-- If the base has the variable, it must be masked. Lookups stay on the fast path
+		-- until this first happens.
+		if rawget(state.base, name) ~= nil then
+			local cleared = state.cleared
+
+			if not cleared then
+				local def = state.def
+
+				cleared = {}
+
+				function state.__index (t, k)
+					if cleared[k] then
+						return def(t, k)
+					else
+						return state.base[k]
+					end
+				end
+
+				state.cleared = cleared
+			end
+
+			cleared[name] = true
+		end
+	end
+
+	-- Assigns a primitive variable in a working set; nil clears it
+	local function Assign (overlay, name, value)
+		if value ~= nil then
+			overlay[name] = value
+		else
+			Clear(overlay, name)
+		end
+	end
+
+	-- Gets a flat copy of a working set
+	local function Flatten (overlay)
+		local state = getmetatable(overlay)
+		local vars = table_ops.Copy(state.base)
+
+		if state.cleared then
+			for k in pairs(state.cleared) do
+				vars[k] = nil
+			end
+		end
+
+		for k, v in pairs(overlay) do
+			vars[k] = v
+		end
+
+		return vars
+	end
+
+	-- Commits a working set's changes into tiers 2 to target; the base is updated in place,
+	-- unless a higher tier also uses it
+	local function Commit (group, target, meta)
+		local overlay = group[1]
+		local state = getmetatable(overlay)
+		local base = state.base
+
+		for i = target + 1, #group do
+			if rawequal(group[i], base) then
+				base = CopySnapshot(base, meta)
+
+				break
+			end
+		end
+
+		if state.cleared then
+			for k in pairs(state.cleared) do
+				base[k] = nil
+			end
+		end
+
+		for k, v in pairs(overlay) do
+			base[k] = v
+		end
+
+		Rebase(overlay, base)
+
+		for i = 2, target do
+			group[i] = base
+		end
+	end
+
+	-- Puts a watched variable on the dirty list, unless already there
+	local function Touch (VF, what, name)
+		local watches = VF[_watches]
+		local entry = watches and watches[what][name]
+
+		if entry and not entry.is_dirty then
+			local dirty = VF[_dirty]
+
+			entry.is_dirty, dirty[#dirty + 1] = true, entry
+		end
+	end
+
+	-- Puts all of a group's watched variables on the dirty list
+	local function TouchAll (VF, what)
+		local watches = VF[_watches]
+
+		if watches then
+			for name in pairs(watches[what]) do
+				Touch(VF, what, name)
+			end
+		end
+	end
+
+	-- Gets a primitive variable's stored value in a working set, or nil if it has none
+	local function Peek (overlay, name)
+		local value = rawget(overlay, name)
+
+		if value == nil then
+			local state = getmetatable(overlay)
+
+			if not (state.cleared and state.cleared[name]) then
+				value = rawget(state.base, name)
+			end
+		end
+
+		return value
+	end
+
+	-- Builds a proxy for a primitive working set, which journals each write: the group,
+	-- the name, and the old value, so that the write can be undone
+	local function NewProxy (VF, what, overlay)
+		local peek = Metas[what].is_native and Native.Peek or Peek
+
+		return setmetatable({}, {
+			__index = overlay,
+			__newindex = function(_, name, value)
+				local journal = VF[_journal]
+
+				if journal then
+					local size = VF[_journal_size]
+
+					journal[size + 1], journal[size + 2], journal[size + 3] = what, name, peek(overlay, name)
+
+					VF[_journal_size] = size + 3
+				end
+
+				Touch(VF, what, name)
+				Assign(overlay, name, value)
+			end,
+			is_proxy = true
+		})
+	end
+
+	-- Puts proxies over the primitive working sets that must see their writes: all of them
+	-- while journaling, else the watched script ones (native stores watch for themselves)
+	local function UpdateProxies (VF)
+		local proxies, journal, watches = VF[_proxies] or {}, VF[_journal], VF[_watches]
+
+		for what, group in pairs(VF[_groups]) do
+			local meta = Metas[what]
+
+			if not (meta.is_prim and (journal or (not meta.is_native and watches and next(watches[what]) ~= nil))) then
+				proxies[what] = nil
+			elseif not proxies[what] then
+				proxies[what] = NewProxy(VF, what, group[1])
+			end
+		end
+
+		VF[_proxies] = proxies
+
+		SetupWorkingSet(VF)
+	end
+
+	-- Starts a fresh journal, or turns journaling off; either way, a new epoch begins, with
+	-- no earlier checkpoint left valid
+	local function ResetJournal (VF, on)
+		VF[_journal], VF[_journal_limits] = on and {} or nil, on and {} or nil
+		VF[_journal_size], VF[_journal_epoch] = on and 0 or nil, (VF[_journal_epoch] or 0) + 1
+	end
+
+	-- Undoes the journal's writes back to a size, in reverse order
+	local function Unwind (VF, size)
+		local groups, journal = VF[_groups], VF[_journal]
+
+		for i = VF[_journal_size], size + 3, -3 do
+			local what, name = journal[i - 2], journal[i - 1]
+
+			Touch(VF, what, name)
+			Assign(groups[what][1], name, journal[i])
+
+			journal[i - 2], journal[i - 1], journal[i] = nil
+		end
+
+		-- Once truncated, the journal may reuse the positions past the new size, so begin
+		-- a new epoch; checkpoints from older ones stay valid only below the cut.
+		if size < VF[_journal_size] then
+			local epoch = VF[_journal_epoch]
+
+			VF[_journal_limits][epoch], VF[_journal_epoch] = size, epoch + 1
+		end
+
+		VF[_journal_size] = size
+	end
+
+	-- Is a snapshot in use outside a range of tiers?
+	local function IsShared (group, snapshot, lo, hi)
+		if rawequal(getmetatable(group[1]).base, snapshot) then
+			return true
+		end
+
+		for i = 2, #group do
+			if (i < lo or i > hi) and rawequal(group[i], snapshot) then
+				return true
+			end
+		end
+	end
+
+	-- Writes a variable into tiers lo to hi of a primitive group, first copying any of
+	-- those snapshots that are in use elsewhere
+	local function WriteThrough (group, lo, hi, name, value, meta)
+		for i = lo, hi do
+			local snapshot = group[i]
+
+			if IsShared(group, snapshot, lo, hi) then
+				local copy = CopySnapshot(snapshot, meta)
+
+				for j = i, hi do
+					if rawequal(group[j], snapshot) then
+						group[j] = copy
+					end
+				end
+
+				snapshot = copy
+			end
+
+			snapshot[name] = value
 		end
 	end
 
 	do
 		-- Boolean variable helpers --
-		local Bools, Pair, PairSet = MakeMeta("bools", func_ops.False, true)
+		local Bools, Pair, PairSet = MakeMeta("bools", func_ops.False, true, true)
 
 		--- 
 		-- @class function
@@ -145,6 +467,17 @@ class.Define("VarFamily", function(VarFamily)
 			return false
 		end)
 
+		-- With native stores, array tests are bit tests over the IDs (or names) in the array.
+		if Metas.bools.is_native then
+			function VarFamily:AllTrue_Array (array)
+				return Native.AllTrue(self[_groups].bools[1], array)
+			end
+
+			function VarFamily:AnyTrue_Array (array)
+				return Native.AnyTrue(self[_groups].bools[1], array)
+			end
+		end
+
 		--- 
 		-- @class function
 		-- @name VarFamily:AllFalse_Array
@@ -491,7 +824,7 @@ class.Define("VarFamily", function(VarFamily)
 
 	do
 		-- Number variable helpers --
-		local Nums, Pair = MakeMeta("nums", func_ops.Zero, true)
+		local Nums, Pair = MakeMeta("nums", func_ops.Zero, true, true)
 
 		---
 		-- @param name Number variable name.
@@ -506,7 +839,7 @@ class.Define("VarFamily", function(VarFamily)
 		-- @param value Value to assign.
 		-- @see VarFamily:GetNumber
 		function VarFamily:SetNumber (name, value)
-			Nums(self)[name] = value
+			Assign(Nums(self), name, value)
 		end
 
 		-- Optional upper-bounding helper
@@ -654,7 +987,7 @@ class.Define("VarFamily", function(VarFamily)
 		function VarFamily:CopyRawTo (name_from, name_to)
 			local raws = Raw(self)
 
-			raws[name_to] = raws[name_from]
+			Assign(raws, name_to, raws[name_from])
 		end
 
 		--- Moves a raw variable into another slot.
@@ -664,8 +997,8 @@ class.Define("VarFamily", function(VarFamily)
 		function VarFamily:MoveRawTo (name_from, name_to)
 			local raws = Raw(self)
 
-			raws[name_to] = raws[name_from]
-			raws[name_from] = nil
+			Assign(raws, name_to, raws[name_from])
+			Clear(raws, name_from)
 		end
 
 		---
@@ -681,7 +1014,12 @@ class.Define("VarFamily", function(VarFamily)
 		-- @return Raw variable, or <b>nil</b> if absent.
 		-- @see VarFamily:GetRaw
 		function VarFamily:PullRaw (name)
-			return Pull(Raw(self), name)
+			local raws = Raw(self)
+			local var = raws[name]
+
+			Clear(raws, name)
+
+			return var
 		end
 
 		---
@@ -689,7 +1027,7 @@ class.Define("VarFamily", function(VarFamily)
 		-- @param value Value to assign, or <b>nil</b> to clear.
 		-- @see VarFamily:GetRaw
 		function VarFamily:SetRaw (name, value)
-			Raw(self)[name] = value
+			Assign(Raw(self), name, value)
 		end
 
 		--- Table variant of <b>VarFamily:SetRaw</b>.
@@ -697,7 +1035,11 @@ class.Define("VarFamily", function(VarFamily)
 		-- named raw variable
 		-- @see VarFamily:SetRaw
 		function VarFamily:SetRaw_Table (t)
-			table_ops.Copy_WithTable(Raw(self), t)
+			local raws = Raw(self)
+
+			for k, v in pairs(t) do
+				raws[k] = v
+			end
 		end
 	end
 
@@ -811,6 +1153,59 @@ class.Define("VarFamily", function(VarFamily)
 
 		local Timers = BuildFuncs("timers", "Timer")
 
+		-- With a bank, the working set's timers keep their state in the family's bank, so that
+		-- one bank update advances them all. Timers in the other tiers are snapshots, so they
+		-- are kept out of it.
+		if UseTimerBank then
+			local TimersMeta = Metas.timers
+
+			-- Bank of each working set --
+			local Banks = table_ops.Weak("k")
+
+			function TimersMeta.__index (timers, name)
+				local timer = class.New("Timer", Banks[timers])
+
+				timers[name] = timer
+
+				return timer
+			end
+
+			function TimersMeta:set_current (VF, group_cur)
+				local bank, prev = VF[_timer_bank], VF[self]
+
+				if prev ~= group_cur then
+					-- Take the outgoing working set's timers out of the bank, and put the
+					-- incoming one's in.
+					if prev then
+						for _, timer in pairs(prev) do
+							timer:SetBank(nil)
+						end
+
+						Banks[prev] = nil
+					end
+
+					for _, timer in pairs(group_cur) do
+						timer:SetBank(bank)
+					end
+
+					Banks[group_cur] = bank
+
+					VF[self] = setmetatable(group_cur, self)
+				end
+			end
+
+			-- Pulled timers leave the working set, and thus the bank.
+			function VarFamily:PullTimer (name)
+				local timer = Pull(Timers(self), name)
+
+				if timer then
+					timer:SetBank(nil)
+				end
+
+				return timer
+			end
+		end
+
 		-- Protected update
 		local function Update (VF, dt, arg)
 			VF[_is_updating] = true
@@ -819,8 +1214,14 @@ class.Define("VarFamily", function(VarFamily)
 				timeline(dt, arg)
 			end
 
-			for _, timer in pairs(Timers(VF)) do
-				timer:Update(dt)
+			local bank = VF[_timer_bank]
+
+			if bank then
+				bank:Update(dt)
+			else
+				for _, timer in pairs(Timers(VF)) do
+					timer:Update(dt)
+				end
 			end
 		end
 
@@ -831,45 +1232,59 @@ class.Define("VarFamily", function(VarFamily)
 			VF[_is_updating] = false
 		end
 
-		--- Updates all current timelines and timers.
+		--- Updates all current timelines and timers, then dispatches any watches.
 		-- @param dt Time step.
 		-- @param arg Argument to timelines.
 		function VarFamily:Update (dt, arg)
 			func_ops.Try(Update, UpdateDone, self, dt, arg)
+
+			self:DispatchWatches()
 		end
 	end
 
 	do
-		-- Automatic propagation helper
-		local function AutoPropagate (VF)
+		-- Automatic propagation helper; tiers below lo are about to be replaced, so are skipped
+		local function AutoPropagate (VF, lo)
 			for what, list in pairs(VF[_auto_propagate]) do
 				local group = VF[_groups][what]
-				local op = Metas[what].is_prim and func_ops.Identity or class.Clone
+				local meta = Metas[what]
 
 				for name, target in pairs(list) do
-					for i = 2, target do
-						group[i][name] = op(group[1][name])
+					if meta.is_prim then
+						WriteThrough(group, lo, target, name, group[1][name], meta)
+					else
+						for i = lo, target do
+							group[i][name] = class.Clone(group[1][name])
+						end
 					end
 				end
 			end
 		end
 
-		-- Group propagate operations
-		local function GetOps (what)
-			if Metas[what].is_prim then
-				return table_ops.Copy
-			else
-				return table_ops.Map, class.Clone
+		-- Propagates copies of a tier downward into the lower tiers; primitive tiers share
+		-- the snapshot, and the working set is emptied on top of it. If the tier was just
+		-- committed from the working set, native stores leave the working set alone.
+		local function Propagate (VF, top, committed)
+			if VF[_journal] then
+				ResetJournal(VF, true)
 			end
-		end
 
-		-- Propagates copies of a tier downward into the lower tiers
-		local function Propagate (VF, top)
 			for what, group in pairs(VF[_groups]) do
-				local op, arg = GetOps(what)
+				if Metas[what].is_native then
+					for i = committed and 2 or 1, top - 1 do
+						Native.Copy(group[i], group[top])
+					end
+				elseif Metas[what].is_prim then
+					for i = 2, top - 1 do
+						group[i] = group[top]
+					end
 
-				for i = 1, top - 1 do
-					group[i] = op(group[top], arg)
+					Rebase(group[1], group[top])
+					TouchAll(VF, what)
+				else
+					for i = 1, top - 1 do
+						group[i] = table_ops.Map(group[top], class.Clone)
+					end
 				end
 			end
 
@@ -900,7 +1315,7 @@ class.Define("VarFamily", function(VarFamily)
 			assert(not self[_is_updating], "Cannot wipe while updating")
 
 			if top > 1 then
-				AutoPropagate(self)
+				AutoPropagate(self, top)
 
 				Propagate(self, top)
 			end
@@ -915,15 +1330,21 @@ class.Define("VarFamily", function(VarFamily)
 			assert(not self[_is_updating], "Cannot commit while updating")
 
 			if target > 1 then
-				AutoPropagate(self)
+				AutoPropagate(self, target + 1)
 
 				for what, group in pairs(self[_groups]) do
-					local op, arg = GetOps(what)
+					local meta = Metas[what]
 
-					group[target] = op(group[1], arg)
+					if meta.is_native then
+						Native.Copy(group[target], group[1])
+					elseif meta.is_prim then
+						Commit(group, target, meta)
+					else
+						group[target] = table_ops.Map(group[1], class.Clone)
+					end
 				end
 
-				Propagate(self, target)
+				Propagate(self, target, true)
 			end
 		end
 
@@ -939,6 +1360,91 @@ class.Define("VarFamily", function(VarFamily)
 		end
 	end
 
+	-- Journal positions per epoch in a checkpoint mark --
+	local MarkSpan = 2^26
+
+	--- Gets a checkpoint in the journal, to which the working set may later be rolled back.
+	-- @return Checkpoint mark, combining the journal's epoch and size.
+	-- @see VarFamily:RollBack, VarFamily:SetJournaled
+	function VarFamily:Checkpoint ()
+		assert(self[_journal], "Journaling is off")
+
+		return self[_journal_epoch] * MarkSpan + self[_journal_size]
+	end
+
+	--- Commits the journal, keeping all writes and invalidating any checkpoints.
+	-- @see VarFamily:RollBack, VarFamily:SetJournaled
+	function VarFamily:CommitJournal ()
+		assert(self[_journal], "Journaling is off")
+
+		ResetJournal(self, true)
+	end
+
+	--- Checks the watched variables on the dirty list, calling the watches on any whose
+	-- value (or predicate result) changed.<br><br>
+	-- Writes made by the watch callbacks are checked by the next dispatch.
+	-- @see VarFamily:Watch
+	function VarFamily:DispatchWatches ()
+		if not self[_watches] then
+			return
+		end
+
+		-- Gather the names off the native stores' dirty lists.
+		for what, group in pairs(self[_groups]) do
+			if Metas[what].is_native then
+				for i = 1, Native.TakeDirty(group[1], DirtyNames) do
+					Touch(self, what, DirtyNames[i])
+				end
+			end
+		end
+
+		-- Swap in a fresh list, then check each variable.
+		local dirty = self[_dirty]
+
+		self[_dirty], self[_dirty_spare] = self[_dirty_spare], dirty
+
+		for i = 1, #dirty do
+			local entry = dirty[i]
+			local name = entry.name
+			local value = self[Metas[entry.what]][name]
+
+			dirty[i], entry.is_dirty = nil, false
+
+			for _, watch in ipairs(entry.list) do
+				if watch.entry then
+					local pred, last = watch.pred, watch.last
+
+					if pred then
+						watch.last = not not pred(value)
+
+						if watch.last and not last then
+							watch.func(self, name, value)
+						end
+					elseif value ~= last then
+						watch.last = value
+
+						watch.func(self, name, value)
+					end
+				end
+			end
+		end
+	end
+
+	---
+	-- @return Fresh array of journal entries, oldest first, where each entry is a table
+	-- with fields <b>group</b>, <b>name</b>, and <b>old</b> (the value before the write,
+	-- or <b>nil</b> if the variable was unset).
+	-- @see VarFamily:SetJournaled
+	function VarFamily:GetJournal ()
+		local entries, journal = {}, self[_journal]
+
+		for i = 3, self[_journal_size] or 0, 3 do
+			entries[#entries + 1] = { group = journal[i - 2], name = journal[i - 1], old = journal[i] }
+		end
+
+		return entries
+	end
+
 	---
 	-- @return Number of variable tiers.
 	function VarFamily:GetTierCount ()
@@ -954,7 +1460,153 @@ class.Define("VarFamily", function(VarFamily)
 	function VarFamily:GetVars (what)
 		local vars = assert(Metas[what], "Invalid variable type")
 
-		return table_ops.Copy(self[vars])
+		if vars.is_native then
+			return Native.GetVars(self[_groups][what][1])
+		elseif vars.is_prim then
+			return Flatten(self[_groups][what][1])
+		else
+			return table_ops.Copy(self[vars])
+		end
+	end
+
+	---
+	-- @return If true, writes to primitive variables are journaled.
+	-- @see VarFamily:SetJournaled
+	function VarFamily:IsJournaled ()
+		return self[_journal] ~= nil
+	end
+
+	--- Rolls the working set back to a checkpoint, undoing the journaled writes made since
+	-- then, newest first. The cost is proportional to the number of those writes.
+	-- @param mark Checkpoint mark, as returned by <b>VarFamily:Checkpoint</b>. If absent,
+	-- rolls back to the last commit.
+	-- @see VarFamily:CommitJournal
+	function VarFamily:RollBack (mark)
+		assert(self[_journal], "Journaling is off")
+
+		local epoch, size = self[_journal_epoch], 0
+
+		if mark ~= nil then
+			assert(var_preds.IsNonNegativeInteger(mark), "Invalid checkpoint")
+
+			epoch, size = floor(mark / MarkSpan), mark % MarkSpan
+		end
+
+		-- A mark from an older epoch is only good if no rollback since then cut below it.
+		local limits, ok = self[_journal_limits], epoch <= self[_journal_epoch] and size % 3 == 0 and size <= self[_journal_size]
+
+		for i = epoch, self[_journal_epoch] - 1 do
+			ok = ok and size <= (limits[i] or -1)
+		end
+
+		assert(ok, "Invalid checkpoint")
+
+		Unwind(self, size)
+	end
+
+	--- Turns journaling on or off. While on, each write to a bool, number, or raw variable
+	-- logs the old value, so checkpoints are O(1) and rollback is O(writes since).<br><br>
+	-- Turning journaling off, or propagating tiers, commits the journal.
+	-- @param on If true, turn journaling on.
+	-- @see VarFamily:Checkpoint, VarFamily:CommitJournal, VarFamily:GetJournal, VarFamily:RollBack
+	function VarFamily:SetJournaled (on)
+		if not on or not self[_journal] then
+			ResetJournal(self, on)
+		end
+
+		UpdateProxies(self)
+	end
+
+	--- Stops a watch.
+	-- @param watch Watch handle, as returned by <b>VarFamily:Watch</b>.
+	-- @see VarFamily:Watch
+	function VarFamily:Unwatch (watch)
+		local entry = watch.entry
+
+		if entry then
+			local list = {}
+
+			for _, other in ipairs(entry.list) do
+				if other ~= watch then
+					list[#list + 1] = other
+				end
+			end
+
+			-- Replace rather than edit the list, in case a dispatch is going through it.
+			watch.entry, entry.list = nil, list
+
+			if #list == 0 then
+				self[_watches][entry.what][entry.name] = nil
+
+				if Metas[entry.what].is_native then
+					Native.Watch(self[_groups][entry.what][1], entry.name, false)
+				end
+
+				UpdateProxies(self)
+			end
+		end
+	end
+
+	--- Watches a primitive variable for changes.<br><br>
+	-- Writes, rollbacks, and the like put watched variables on a dirty list; only those are
+	-- checked, in a batch, by <b>VarFamily:DispatchWatches</b>, which each update calls.
+	-- @param group Variable group: <b>"bools"</b>, <b>"nums"</b>, or <b>"raw"</b>.
+	-- @param name Non-<b>nil</b> variable name.
+	-- @param func Callback, called as<br><br>
+	-- &nbsp&nbsp&nbsp<i><b>func(VF, name, value)</b></i>.
+	-- @param pred Optional predicate, called as <i><b>pred(value)</b></i>, e.g. a test
+	-- that a number is at least some threshold. If present, <i>func</i> is called whenever
+	-- its result turns true; otherwise, whenever the value changes.
+	-- @return Watch handle.
+	-- @see VarFamily:Unwatch
+	function VarFamily:Watch (group, name, func, pred)
+		local meta = Metas[group]
+
+		assert(meta and meta.is_prim, "Invalid group")
+		assert(name ~= nil, "Invalid name")
+		assert(var_preds.IsCallable(func), "Uncallable watch function")
+		assert(var_preds.IsCallableOrNil(pred), "Uncallable predicate")
+
+		-- Watch IDs under their names; other numbers are names already.
+		if meta.is_native and type(name) == "number" then
+			name = Native.GetName(name) or name
+		end
+
+		-- Start watching the variable, if this is the first watch on it.
+		local watches = self[_watches]
+
+		if not watches then
+			watches = table_ops.SubTablesOnDemand()
+
+			self[_watches], self[_dirty], self[_dirty_spare] = watches, {}, {}
+		end
+
+		local entry = watches[group][name]
+
+		if not entry then
+			entry = { what = group, name = name, list = {} }
+
+			watches[group][name] = entry
+
+			if meta.is_native then
+				Native.Watch(self[_groups][group][1], name, true)
+			end
+		end
+
+		-- Add the watch, noting the value or predicate result to compare against.
+		local value, watch = self[meta][name], { entry = entry, func = func, pred = pred }
+
+		if pred then
+			watch.last = not not pred(value)
+		else
+			watch.last = value
+		end
+
+		entry.list[#entry.list + 1] = watch
+
+		UpdateProxies(self)
+
+		return watch
 	end
 
 	--- Class constructor.
@@ -965,11 +1617,20 @@ class.Define("VarFamily", function(VarFamily)
 		-- Automatically propagated variables --
 		self[_auto_propagate] = table_ops.SubTablesOnDemand()
 
+		-- Working set timer bank --
+		if UseTimerBank then
+			self[_timer_bank] = class.New("TimerBank")
+		end
+
 		-- Variables groups --
 		self[_groups] = {}
 
-		for what in pairs(Metas) do
-			self[_groups][what] = table_ops.ArrayOfTables(tier_count)
+		for what, meta in pairs(Metas) do
+			if meta.is_prim then
+				self[_groups][what] = NewTiers(what, meta, tier_count)
+			else
+				self[_groups][what] = table_ops.ArrayOfTables(tier_count)
+			end
 		end
 
 		SetupWorkingSet(self)
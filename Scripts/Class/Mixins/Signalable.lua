@@ -20,8 +20,11 @@ local IsCallable = var_preds.IsCallable
 local IsCallableOrNil = var_preds.IsCallableOrNil
 local IsTable = var_preds.IsTable
 
+-- Native signal dispatcher, unless disabled at boot --
+local Dispatch = UseNativeSignals ~= false and signal_dispatch
+
 -- Slot store --
-local Slots = table_ops.SubTablesOnDemand("k")
+local Slots = not Dispatch and table_ops.SubTablesOnDemand("k")
 
 -- Signalable class definition --
 class.Define("Signalable", function(Signalable)
@@ -32,6 +35,17 @@ class.Define("Signalable", function(Signalable)
 		return slot_table and slot_table[S]
 	end
 
+	-- Adds a listener to a signal
+	local function Add (S, signal, slot)
+		Slots[signal][S] = slot
+	end
+
+	-- With the native dispatcher, each object instead keeps its slots in an array, indexed
+	-- by interned signal name.
+	if Dispatch then
+		GetSlot, Add = Dispatch.GetSlot, Dispatch.SetSlot
+	end
+
 	---
 	-- @class function
 	-- @name Signalable:GetSlot
@@ -40,11 +54,6 @@ class.Define("Signalable", function(Signalable)
 	-- @see Signalable:SetSlot
 	Signalable.GetSlot = GetSlot
 
-	-- Adds a listener to a signal
-	local function Add (S, signal, slot)
-		Slots[signal][S] = slot
-	end
-
 	--- Multiple-signal variant of <b>Signalable:SetSlot</b>.
 	-- @param signals_and_slots Table of (<i>signal</i>, <i>slot</i>) pairs.
 	-- @see Signalable:SetSlot
@@ -85,4 +94,9 @@ class.Define("Signalable", function(Signalable)
 			return slot(self, ...)
 		end
 	end
+
+	-- The native dispatcher does the lookup and call in one go.
+	if Dispatch then
+		Signalable.Signal = Dispatch.Signal
+	end
 end)
\ No newline at end of file
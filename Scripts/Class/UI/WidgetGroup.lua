@@ -24,6 +24,7 @@ local MemberTable = lazy_ops.MemberTable
 local New = class.New
 local NoOp = func_ops.NoOp
 local SetLocalRect = widget_ops.SetLocalRect
+local SignalMany = widget_ops.SignalMany
 local SubTablesOnDemand = table_ops.SubTablesOnDemand
 local SuperCons = class.SuperCons
 local Try_Multi = func_ops.Try_Multi
@@ -150,9 +151,7 @@ class.Define("WidgetGroup", function(WidgetGroup)
             if list then
 				local alert = list.alert or slot .. "_alert"
 
-				for _, v in ipairs(list) do
-					v:Signal(alert, WG, state)
-				end
+				SignalMany(list, alert, WG, state)
 
 				list.alert = alert
             end
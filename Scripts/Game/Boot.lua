@@ -22,6 +22,15 @@ return {
 
 	"Game",
 
+	-- Metacompiler chunk cache --
+	function()
+		local chunk_cache_file = debug_config.chunk_cache_file
+
+		if chunk_cache_file then
+			require("metacompiler").SetChunkCacheFile(chunk_cache_file)
+		end
+	end,
+
 	-- Metacompiler listings --
 	function()
 		local listings_file = debug_config.listings_file
@@ -1,17 +1,24 @@
 -- Standard library imports --
 local assert = assert
+local byte = string.byte
 local concat = table.concat
+local dump = string.dump
 local format = string.format
 local gsub = string.gsub
 local ipairs = ipairs
 local loadstring = loadstring
 local lower = string.lower
 local match = string.match
+local open = io.open
 local pairs = pairs
+local pcall = pcall
 local rep = string.rep
+local setfenv = setfenv
 local setmetatable = setmetatable
 local sub = string.sub
 local tostring = tostring
+local unpack = unpack
+local _VERSION = _VERSION
 
 -- Modules --
 local cache_ops = require("cache_ops")
@@ -23,6 +30,12 @@ local table_ops = require("table_ops")
 local var_ops = require("var_ops")
 local var_preds = require("var_preds")
 
+-- Native variable store, unless disabled at boot --
+local VarStore = UseNativeVarStore ~= false and var_store
+
+-- Virtual machine, whose bytecode goes in the chunk cache --
+local VM = jit and jit.version or _VERSION
+
 -- Cached routines --
 local _Declare_
 local _InterpVar_
@@ -39,7 +52,7 @@ local ParamsWithObject = Params .. ", object)\n"
 local CallFunc = "%s\t%s%s(" .. ParamsWithObject .. "%s"
 
 -- Form of chunk body; generated function is returned when chunk runs --
-local Body = "-- %s\n%sreturn function(" .. Params .. ", object%s)\n%s\nend"
+local Body = "%sreturn function(" .. Params .. ", object%s)\n%s\nend"
 
 -- Output function --
 local OutputFunc
@@ -70,14 +83,65 @@ local function GetDeclaration ()
 	return #Names > 0 and format("local %s = ...\n\n", ConcatAndWipe(Names)) or ""
 end
 
--- Helper to build and initialize chunk
-local function PrimeChunk (cstr, ...)
-	return assert(loadstring(cstr))(...)
+-- Compiled chunks, keyed by source; since upvalues are passed in when a chunk runs, each
+-- source need only be compiled once --
+local Chunks = {}
+
+-- Chunks loaded from the cache file, not yet used --
+local FromFile = {}
+
+-- Chunk cache statistics --
+local Hits, FileHits, Misses = 0, 0, 0
+
+-- Chunk cache file, and whether it is out of date --
+local CacheFile, IsCacheStale
+
+-- Chunk cache file layout version; bump it whenever the layout or the generated code changes --
+local CacheFormat = 1
+
+-- Helper to hash a string, continuing from an earlier hash
+local function Hash (str, hash)
+	hash = hash or 5381
+
+	for i = 1, #str do
+		hash = (hash * 33 + byte(str, i)) % 4294967296
+	end
+
+	return hash
+end
+
+-- Helper to build and initialize chunk, reusing it if the source was seen before
+local function PrimeChunk (cstr, about, ...)
+	local chunk = Chunks[cstr]
+
+	if FromFile[cstr] then
+		FileHits, FromFile[cstr] = FileHits + 1
+	elseif chunk then
+		Hits = Hits + 1
+	else
+		chunk, Misses, IsCacheStale = assert(loadstring(cstr, "-- " .. about)), Misses + 1, true
+
+		Chunks[cstr] = chunk
+	end
+
+	return chunk(...)
+end
+
+-- Helper to describe the chunk cache
+local function CacheReport ()
+	local total = Hits + FileHits + Misses
+
+	return format("-- CHUNK CACHE: %i hits (%i from file), %i compiles; hit rate %.1f%%", Hits + FileHits, FileHits, Misses, 100 * (Hits + FileHits) / total)
+end
+
+-- Helper to indicate whether output is being listed
+local function IsListing ()
+	return ShouldListOutput and OutputFunc
 end
 
 -- Helper to list a string
 local function List (str)
-	if ShouldListOutput and OutputFunc then
+	if IsListing() then
 		if var_preds.IsPositive(FormatLayerCount) then
 			str = gsub(str, "%%", rep("%%", FormatLayerCount * 2))
 		end
@@ -86,21 +150,144 @@ local function List (str)
 	end
 end
 
+-- Functions deferred by the batch being built, if any --
+local Batch
+
+-- Stand-in metatable; calling a stand-in compiles its function on the spot --
+local StandInMeta = {}
+
+-- Helper to compile and bind a deferred function, putting it in the stand-in's place
+local function Resolve (stand_in)
+	local func = stand_in.func
+
+	if not func then
+		func = game_state.BoundStateVarsFunc_Arg(PrimeChunk(stand_in.cstr, stand_in.about, unpack(stand_in)))
+
+		if IsListing() then
+			List(format("-- %s\n%s\n%s", stand_in.about, stand_in.cstr, CacheReport()))
+		end
+
+		stand_in.func = func
+
+		if stand_in.flist then
+			stand_in.flist[stand_in.key] = func
+		end
+	end
+
+	return func
+end
+
+function StandInMeta:__call (object, choice)
+	return Resolve(self)(object, choice)
+end
+
 -- Builds the final function, given a body and any inner function
 local function BuildFunc (body, about, has_choice)
 	-- If no body has been built up, return nothing. Otherwise, assemble and run the
 	-- chunk, finally binding it to the variable families. If an inner function was
 	-- specified, a fourth parameter is added to receive function input.
 	if #body > 0 then
-		local cstr = format(Body, about, GetDeclaration(), has_choice and ", choice" or "", body)
-		local func = PrimeChunk(cstr, var_ops.UnpackAndWipe(Values))
+		local cstr = format(Body, GetDeclaration(), has_choice and ", choice" or "", body)
 
-		List(cstr)
+		-- While a batch is being built, leave the compile for later, returning a stand-in.
+		if Batch then
+			local stand_in = setmetatable({ cstr = cstr, about = about, var_ops.UnpackAndWipe(Values) }, StandInMeta)
+
+			Batch[#Batch + 1] = stand_in
+
+			return stand_in
+		end
+
+		local func = PrimeChunk(cstr, about, var_ops.UnpackAndWipe(Values))
+
+		if IsListing() then
+			List(format("-- %s\n%s\n%s", about, cstr, CacheReport()))
+		end
 
 		return game_state.BoundStateVarsFunc_Arg(func)
 	end
 end
 
+---
+-- @return Chunk cache hits (including file hits), hits on chunks from the cache file, and
+-- compiles.
+-- @see SetChunkCacheFile
+function GetChunkCacheStats ()
+	return Hits + FileHits, FileHits, Misses
+end
+
+--- Saves the compiled chunks to the cache file, if any, when new ones have been compiled.
+-- @see SetChunkCacheFile
+function SaveChunkCache ()
+	if CacheFile and IsCacheStale then
+		local file = open(CacheFile, "wb")
+
+		if file then
+			file:write(format("return {\nformat = %i,\nvm = %q,\nchunks = {\n", CacheFormat, VM))
+
+			for cstr, chunk in pairs(Chunks) do
+				local bytecode = dump(chunk)
+
+				file:write(format("{ %q, %q, %.0f },\n", cstr, bytecode, Hash(bytecode, Hash(cstr))))
+			end
+
+			file:write("}\n}\n")
+			file:close()
+
+			IsCacheStale = false
+		end
+	end
+end
+
+-- Helper to read the chunk cache file's entries, if its header and every hash check out
+local function ReadChunkCache (file)
+	local loader = loadstring(file:read("*a"))
+
+	file:close()
+
+	local ok, cache = pcall(setfenv(loader or function() end, {}))
+
+	if ok and var_preds.IsTable(cache) and cache.format == CacheFormat and cache.vm == VM and var_preds.IsTable(cache.chunks) then
+		local entries = {}
+
+		for _, entry in ipairs(cache.chunks) do
+			local cstr, bytecode, hash = entry[1], entry[2], entry[3]
+
+			if not (var_preds.IsString(cstr) and var_preds.IsString(bytecode) and hash == Hash(bytecode, Hash(cstr))) then
+				return nil
+			end
+
+			entries[cstr] = bytecode
+		end
+
+		return entries
+	end
+end
+
+--- Sets a file in which to persist compiled chunks, loading any already there.<br><br>
+-- The file maps each chunk's source, upvalue declarations included, to its bytecode, and
+-- records the layout version and virtual machine it was written for, along with a hash of
+-- each entry. If any of these fail to match, the whole cache is discarded, to be rewritten
+-- once new chunks are compiled. Entries that fail to load are ignored.
+-- @param name File name, or <b>nil</b> to stop persisting.
+-- @see SaveChunkCache
+function SetChunkCacheFile (name)
+	assert(name == nil or var_preds.IsString(name), "Invalid file name")
+
+	CacheFile = name
+
+	local file = name and open(name, "rb")
+	local entries = file and ReadChunkCache(file)
+
+	for cstr, bytecode in pairs(entries or {}) do
+		local chunk = not Chunks[cstr] and loadstring(bytecode)
+
+		if chunk then
+			Chunks[cstr], FromFile[cstr] = chunk, true
+		end
+	end
+end
+
 --- Declares an upvalue for the function being built.
 -- @param name
 -- @param value
@@ -121,6 +308,30 @@ function Declare (name, value)
 	return name
 end
 
+--- Gets the form in which to embed a bool or number variable's name in generated code.<br><br>
+-- With the native variable store, this is the name's interned ID, so that compiled lookups
+-- skip hashing the name; otherwise, it is the quoted name.
+-- @param name Variable name.
+-- @param interp If true, variable interpolations are applied first. A name only known at
+-- run time is left as the expression that builds it.
+-- @return Code string.
+-- @see InterpVar
+function InternVar (name, interp)
+	local is_expr
+
+	if interp then
+		name, is_expr = _InterpVar_(name, true)
+	end
+
+	if is_expr then
+		return name
+	elseif VarStore then
+		return tostring(VarStore.Intern(name))
+	else
+		return format("%q", name)
+	end
+end
+
 -- Compile contexts --
 local Contexts = {}
 
@@ -204,7 +415,9 @@ do
 	--- Applies any variable interpolations.
 	-- @param var_name
 	-- @param no_quote
-	-- @return
+	-- @return Code string.
+	-- @return If true, the name is built at run time, and the code is the expression that
+	-- does so.
 	function InterpVar (var_name, no_quote)
 		TotalSize = #var_name
 
@@ -214,7 +427,7 @@ do
 			if #FormatArgs > 0 then
 				_Declare_("string_format", format)
 
-				return format("string_format(%q, %s)", var_name, ConcatAndWipe(FormatArgs))
+				return format("string_format(%q, %s)", var_name, ConcatAndWipe(FormatArgs)), true
 
 			elseif not no_quote then
 				return format("%q", var_name)
@@ -465,6 +678,85 @@ do
 		return LazyGetFunc(Conditions[node], key, AuxCondition, node, name, cid)(object)
 	end
 
+	-- Helper to build each entry of a batch, leaving stand-ins for the functions
+	local function BuildBatch (entries)
+		for _, entry in ipairs(entries) do
+			local node, key, flist, func = entry.node, entry.key
+
+			assert(node, "Nil batch node")
+
+			if entry.is_condition then
+				flist = Conditions[node]
+				func = LazyGetFunc(flist, key, AuxCondition, node, entry.name, entry.cid)
+			else
+				flist = Actions[node]
+				func = LazyGetFunc(flist, key, AuxAction, node, entry.name, entry.cid)
+			end
+
+			-- Point any new stand-in at its slot, so that the function takes its place.
+			if func == Batch[#Batch] and not func.flist then
+				func.flist, func.key = flist, key
+			end
+		end
+	end
+
+	-- Helper to end the batch build phase
+	local function EndBatch ()
+		Batch = nil
+	end
+
+	--- Compiles a batch of actions and conditions, say all of those of a scene or zone, before
+	-- their first calls.<br><br>
+	-- All bodies are built first. Bodies with the same source, upvalue declarations included,
+	-- then share a single compile, after which each body's function is bound, via <b>
+	-- game_state.BoundStateVarsFunc_Arg</b>, to its own upvalues. Entries already compiled are
+	-- left alone.<br><br>
+	-- Chunks cannot be compiled apart from the Lua state, so rather than spread the work over
+	-- threads, a batch can be spread over frames by yielding after each compile. Should one
+	-- of its functions be called before the batch finishes, it is compiled then.
+	-- @param entries Array of entries, each a table with the <b>node</b>, <b>name</b>, <b>key
+	-- </b>, and <b>cid</b> arguments of <b>CallAction</b> or <b>CallCondition</b>, and a
+	-- <b>is_condition</b> field, true for conditions.
+	-- @param yield Optional function, called after each compile, e.g. <b>coroutine.yield</b>
+	-- when the batch is run in a coroutine.
+	-- @param should_list If true, listings are made as the functions are bound.
+	-- @return Number of bodies built.
+	-- @return Number of unique bodies among them.
+	function CompileBatch (entries, yield, should_list)
+		assert(not Batch, "Batch already in progress")
+		assert(var_preds.IsCallableOrNil(yield), "Uncallable yield")
+
+		Batch = {}
+
+		local batch = Batch
+
+		func_ops.Try(BuildBatch, EndBatch, entries)
+
+		-- Bind each body. The first of each group pays the compile, the rest hitting the cache.
+		local unique, nunique = {}, 0
+
+		ListOutput(should_list)
+
+		for _, stand_in in ipairs(batch) do
+			local cstr = stand_in.cstr
+			local is_new = not Chunks[cstr]
+
+			if not unique[cstr] then
+				unique[cstr], nunique = true, nunique + 1
+			end
+
+			Resolve(stand_in)
+
+			if is_new and yield then
+				yield()
+
+				ListOutput(should_list)
+			end
+		end
+
+		return #batch, nunique
+	end
+
 	--
 	local function ClearList (list)
 		for k in pairs(list) do
@@ -472,7 +764,7 @@ do
 		end
 	end
 
-	---
+	--- Clears per-zone state, saving any newly compiled chunks.
 	function CleanUp ()
 		-- Empty the action bookend lists.
 		ClearList(Prologues)
@@ -492,6 +784,8 @@ do
 
 			Actions[node] = nil
 		end
+
+		SaveChunkCache()
 	end
 
 	---
@@ -58,12 +58,18 @@ objects_helpers.DefineReader("CompoundConditionNode_cl", function(context, expr,
 	return format(expr, ProcessArgs(context, ...))
 end)
 
--- BaseVar reader --
-objects_helpers.DefineReader("BaseVar", function(_, bvar, interp)
+-- BaseVar reader; family bools and numbers may be interned --
+objects_helpers.DefineReader("BaseVar", function(_, bvar, interp, intern)
 	local family, name = em.PushBaseVar(bvar)
 	local is_family = family ~= "ObjectProperty" and family ~= "GlobalProperty"
 
-	return is_family and format("%sVars", family), interp and mc.InterpVar(name) or format("%q", name), family == "GlobalProperty"
+	if is_family and intern then
+		name = mc.InternVar(name, interp)
+	else
+		name = interp and mc.InterpVar(name) or format("%q", name)
+	end
+
+	return is_family and format("%sVars", family), name, family == "GlobalProperty"
 end)
 
 -- Copy_ActionComponent_cl reader --
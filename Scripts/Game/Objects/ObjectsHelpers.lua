@@ -5,12 +5,14 @@ local insert = table.insert
 local tostring = tostring
 
 -- Modules --
+local coroutine_ex = require("coroutine_ex")
 local em = require("entity_manager")
 local func_ops = require("func_ops")
 local game_state = require("game_state")
 local iterators = require("iterators")
 local mc = require("metacompiler")
 local table_ops = require("table_ops")
+local var_ops = require("var_ops")
 local var_preds = require("var_preds")
 
 -- Cached routines --
@@ -91,22 +93,53 @@ do
 		Contexts[what] = options and table_ops.Copy(options) or false
 	end
 
-	-- Commit objects on entering a scene or zone.
+	-- Action and condition definitions read while loading the scene or zone --
+	local Pending = {}
+
+	--- Collects an object's action or condition as the scene or zone is loaded. On entry,
+	-- all of those collected are compiled as a batch, ahead of their first calls.
+	-- @param node Action or condition node.
+	-- @param name Name, as passed to <b>metacompiler.CallAction</b> or <b>CallCondition</b>.
+	-- @param key Key, likewise.
+	-- @param cid Compile context ID, likewise.
+	-- @param is_condition If true, the node is a condition.
+	-- @see metacompiler.CompileBatch
+	function CollectDefinition (node, name, key, cid, is_condition)
+		assert(node ~= nil, "Nil node")
+
+		Pending[#Pending + 1] = { node = node, name = name, key = key, cid = cid, is_condition = not not is_condition }
+	end
+
+	-- Helper to compile the collected definitions
+	local function CompilePending ()
+		if #Pending > 0 then
+			func_ops.Try(mc.CompileBatch, var_ops.WipeRange, Pending)
+		end
+	end
+
+	-- Compile the collected definitions, then commit objects, on entering a scene or zone.
 	ControlVars:GetDelegate("on_enter_scene"):AddAfter(function()
 game_state.GetStateVars("scene"):SetNumber("Twee", 3)
 game_state.GetStateVars("zone"):SetNumber("Mirble", 4)
 game_state.GetStateVars("scene"):GetTimer("meep!")
 game_state.GetStateVars("scene"):GetTimer("meep!"):Start(3)
+		CompilePending()
+
 		em.CommitObjects(false)
 	end)
 
 	ControlVars:GetDelegate("on_enter_zone"):AddAfter(function()
+		CompilePending()
+
 		em.CommitObjects(true)
 	end)
 
 	-- Free resources on leaving a scene or zone.
 	ControlVars:GetDelegate("on_free_scene_resources"):AddAfter(function()
 		em.CleanUpObjects(false)
+
+		-- Let go of coroutine threads left idle over the scene.
+		coroutine_ex.ShrinkPool()
 	end)
 
 	ControlVars:GetDelegate("on_free_zone_resources"):AddAfter(function()
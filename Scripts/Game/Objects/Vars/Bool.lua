@@ -7,7 +7,7 @@ local objects_helpers = require("game_objects_helpers")
 
 --
 local function ReadBool (_, bvar, op, interp, extra)
-	local family, name, global = objects_helpers.ReadElement(_, "BaseVar", bvar, interp)
+	local family, name, global = objects_helpers.ReadElement(_, "BaseVar", bvar, interp, true)
 
 	if family then
 		return format("%s:%s(%s%s)", family, op, name, extra or "")
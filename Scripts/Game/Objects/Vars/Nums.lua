@@ -16,7 +16,7 @@ local var_preds = require("var_preds")
 
 -- Shorthand for common read calls
 local function ReadBase (_, bvar, interp)
-	return objects_helpers.ReadElement(_, "BaseVar", bvar, interp)
+	return objects_helpers.ReadElement(_, "BaseVar", bvar, interp, true)
 end
 
 local function ReadNum (_, nvar)
@@ -1,5 +1,35 @@
 return {
 	function()
+		-- If false, table_ops uses its script kernels even when the native ones are bound.
+		UseNativeTableOps = true
+
+		-- If false, pooled table caches behave as ordinary ones even when the native pool is bound.
+		UseNativeTablePool = true
+
+		-- If false, coroutine_ex.Wrap creates its coroutines even when the native pool is bound.
+		UseNativeCoroutinePool = true
+
+		-- If false, Delegate runs its call chain in script even when the native one is bound.
+		UseNativeDelegates = true
+
+		-- If false, Signalable keeps its slots in script tables even when the native dispatcher is bound.
+		UseNativeSignals = true
+
+		-- If false, Timeline schedules its events in a sorted list even when the native timer wheel is bound.
+		UseNativeTimerWheel = true
+
+		-- If false, VarFamily keeps its timers' state in the timers themselves even when the native timer bank is bound.
+		UseNativeTimerBank = true
+
+		-- If false, var_preds uses its script predicates even when the native ones are bound.
+		UseNativeVarPreds = true
+
+		-- If false, VarFamily keeps bools and numbers in script tables even when the native store is bound.
+		UseNativeVarStore = true
+
+		-- If true, var_ops.AssertArg_Pred skips its test and just returns the argument (release builds).
+		ElideArgAsserts = false
+
 		require("strict")
 
 		debug.sethook()
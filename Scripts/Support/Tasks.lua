@@ -7,6 +7,7 @@ local min = math.min
 local type = type
 
 -- Imports --
+local GetMember = class.GetMember
 local GetTimeLapseFunc = func_ops.GetTimeLapseFunc
 local IsCallable = var_preds.IsCallable
 local IsCallableOrNil = var_preds.IsCallableOrNil
@@ -16,6 +17,23 @@ local NoOp = func_ops.NoOp
 ---
 module "tasks"
 
+-- Lookup for time owed to tasks deferred by a budgeted queue --
+local TakeCarriedLapse
+
+-- Gets the time lapse function used by tasks
+-- Returns: Time lapse function, which adds in any carried lapse, the first time it is
+-- called during a task's run
+--------------------------------------------------------------------------------------
+function GetLapseFunc ()
+	local diff = GetTimeLapseFunc("tasks")
+
+	TakeCarriedLapse = TakeCarriedLapse or GetMember("TaskQueue", "TakeCarriedLapse")
+
+	return function()
+		return diff() + TakeCarriedLapse()
+	end
+end
+
 -- Builds a task that persists until interruption
 -- update: Update routine
 -- quit: Optional quit routine
@@ -26,7 +44,7 @@ function PersistUntil (update, quit)
 	assert(IsCallableOrNil(quit), "Uncallable quit function")
 
 	local age = 0
-	local diff = GetTimeLapseFunc("tasks")
+	local diff = GetLapseFunc()
 
 	-- Build a persistent task.
 	return function(arg)
@@ -52,7 +70,7 @@ function WithInterpolator (interpolator, prep, quit)
 
  	prep = prep or NoOp
 
-	local diff = GetTimeLapseFunc("tasks")
+	local diff = GetLapseFunc()
 
 	return function(arg)
 		local lapse = diff()
@@ -78,7 +96,7 @@ local function SetupTimer (timer)
 	if type(timer) == "number" then
 		local duration = timer
 
-		diff = GetTimeLapseFunc("tasks")
+		diff = GetLapseFunc()
 		timer = New("Timer")
 
 		timer:Start(duration)
@@ -137,7 +155,7 @@ function WithTimeline (timeline, func, quit, time, is_absolute)
 
 	-- Build a fresh timeline if one was not provided.
 	if not timeline then
-		diff = GetTimeLapseFunc("tasks")
+		diff = GetLapseFunc()
 		timeline = New("Timeline")
 	end
 
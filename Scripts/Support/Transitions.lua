@@ -2,16 +2,23 @@
 
 -- Standard library imports --
 local assert = assert
+local getmetatable = getmetatable
 local ipairs = ipairs
 local max = math.max
 local min = math.min
+local newproxy = newproxy
+local setmetatable = setmetatable
+local type = type
 local unpack = unpack
 
 -- Imports --
 local Args = iterators.Args
 local CollectArgsInto = var_ops.CollectArgsInto
 local GetFields = table_ops.GetFields
+local GetFrameID = user_state.GetFrameID
+local GetMember = class.GetMember
 local GetSize = user_state.GetSize
+local GetTimeLapseFunc = func_ops.GetTimeLapseFunc
 local IsType = class.IsType
 local New = class.New
 local NoOp = func_ops.NoOp
@@ -107,6 +114,120 @@ local function InterpolatorTask (func, duration, options, quit_main)
 	end or quit)
 end
 
+-- Tweens --
+local TweenTask
+
+do
+	-- Shared tween bank, with its time lapse function and the frame it was last driven --
+	local Bank, Lapse, Driven
+
+	-- Lookup for time owed to tasks deferred by a budgeted queue --
+	local TakeCarriedLapse
+
+	-- Advances the shared bank, the first time this is called in a frame
+	local function Drive ()
+		local id = GetFrameID()
+
+		if id ~= Driven then
+			Driven = id
+
+			Bank:Update(Lapse())
+		end
+	end
+
+	-- Builds a task that runs tweens on the shared bank; custom maps are passed along as
+	-- the easing
+	-- tweens: Array of { target, setter, from, to } tween entries
+	-- duration: Transition duration
+	-- options: Transition options
+	-- check: Routine called on each update, before the bank is driven
+	-- quit_main: Transition-specific quit logic
+	-- Returns: Task
+	------------------------------------------------------------------------------------
+	function TweenTask (tweens, duration, options, check, quit_main)
+		local mode, ease, quit
+
+		if options then
+			assert(not (options.ease and options.map), "Options may supply an ease or a map, but not both")
+
+			mode = options.mode
+			ease = options.ease or options.map
+			quit = options.quit
+		end
+
+		-- The bank is shared, so it runs on the raw lapse; time owed to a deferred task is
+		-- made up on that task's own tweens.
+		if not Bank then
+			Bank, Lapse = New("TweenBank"), GetTimeLapseFunc("tasks")
+			TakeCarriedLapse = GetMember("TaskQueue", "TakeCarriedLapse")
+		end
+
+		local ids, guard
+
+		return function(arg)
+			check()
+
+			-- On the first run, claim slots for the tweens, and place the targets at their
+			-- initial values.
+			if not ids then
+				local t0 = type(ease) == "function" and ease(0, false) or 0
+
+				ids = {}
+
+				for i, tween in ipairs(tweens) do
+					local target, setter, from, to = unpack(tween)
+
+					ids[i] = Bank:Add(target, setter, from, to, duration, mode, ease)
+
+					target[setter](target, from + (to - from) * t0)
+				end
+
+				-- If the task is abandoned, release its tweens once it is collected. IDs go
+				-- stale once their tweens finish, so this is harmless in the usual case.
+				guard = newproxy(true)
+
+				getmetatable(guard).__gc = function()
+					for _, id in ipairs(ids) do
+						Bank:Remove(id)
+					end
+				end
+			end
+
+			local carried = TakeCarriedLapse()
+
+			if carried > 0 then
+				for _, id in ipairs(ids) do
+					Bank:Skip(id, carried)
+				end
+			end
+
+			Drive()
+
+			-- Tweens in a transition all finish together, so the first one that is still
+			-- running decides the matter.
+			for _, id in ipairs(ids) do
+				if Bank:IsActive(id) then
+					return "keep"
+				end
+			end
+
+			-- Done: the IDs are stale, so the guard can go whenever.
+			guard = nil;
+
+			(quit_main or NoOp)();
+			(quit or NoOp)(arg)
+		end
+	end
+end
+
+-- Indicates whether a transition can run on the tween bank
+-- options: Transition options
+-- Returns: If true, the transition needs no interpolator
+-------------------------------------------------------------
+local function CanTween (options)
+	return not (options and options.prep)
+end
+
 -- Position --
 do
 	local Cache = TableCache("wipe_range")
@@ -139,6 +260,31 @@ do
         return x1, y1, x2 and x2 - x1 or dx or ddx, y2 and y2 - y1 or dy or ddy, xfunc or Linear, yfunc or Linear
 	end
 
+	-- Builds a task that moves widgets on the tween bank, with no per-widget Lua calls
+	-- other than the setters and attachment checks
+	-- motion: Array of { widget, x, y, dx, dy } motion entries
+	-- duration: Transition duration
+	-- options: Transition options
+	-- quit_main: Transition-specific quit logic
+	-- Returns: Task
+	---------------------------------------------------------------------------------
+	local function MoveTask (motion, duration, options, quit_main)
+		local tweens = {}
+
+		for _, item in ipairs(motion) do
+			local widget, x, y, dx, dy = unpack(item)
+
+			tweens[#tweens + 1] = { widget, "SetX", x, x + dx }
+			tweens[#tweens + 1] = { widget, "SetY", y, y + dy }
+		end
+
+		return TweenTask(tweens, duration, options, function()
+			for _, item in ipairs(motion) do
+				assert(item[1]:IsAttached(), "Attempt to move unattached widget")
+			end
+		end, quit_main)
+	end
+
 	-- Builds a task to move a widget
 	-- widget: Widget handle
 	-- duration: Transition duration
@@ -149,6 +295,10 @@ do
     function MoveWidget (widget, duration, how, options)
 		local x, y, dx, dy, xfunc, yfunc = GetMoveValues(widget, how, 0, 0)
 
+		if xfunc == Linear and yfunc == Linear and CanTween(options) then
+			return MoveTask({ { widget, x, y, dx, dy } }, duration, options)
+		end
+
         -- Supply an iterator to place widgets at their current positions.
         return InterpolatorTask(function(t)
 			assert(widget:IsAttached(), "Attempt to move unattached widget")
@@ -169,13 +319,29 @@ do
         -- Build up a batch of motion tracking information.
         local motion = Cache("pull")
 		local ddx, ddy = how.dx or 0, how.dy or 0
+		local can_tween = true
 
         for i, widget in ipairs(widgets) do
             motion[i] = Cache("pull")
 
             CollectArgsInto(motion[i], widget, GetMoveValues(widget, how[i], ddx, ddy))
+
+			can_tween = can_tween and motion[i][6] == Linear and motion[i][7] == Linear
         end
 
+		-- Where possible, move the whole batch on the tween bank.
+		local function Cleanup ()
+			for _, item in ipairs(motion) do
+				Cache(item)
+			end
+
+			Cache(motion)
+		end
+
+		if can_tween and CanTween(options) then
+			return MoveTask(motion, duration, options, Cleanup)
+		end
+
         -- Supply an iterator to place widgets at their current positions.
         return InterpolatorTask(function(t)
             for _, item in ipairs(motion) do
@@ -186,13 +352,7 @@ do
                 widget:SetX(xfunc(x, dx, t))
                 widget:SetY(yfunc(y, dy, t))
             end
-        end, duration, options, function()
-        	for _, item in ipairs(motion) do
-        		Cache(item)
-        	end
-
-			Cache(motion)
-		end)
+        end, duration, options, Cleanup)
     end
 
 	-- Builds a task to place a widget
@@ -254,6 +414,22 @@ do
 		end
 	}
 
+	-- Tween setters, which move the view origin along one axis --
+	local Setters = {}
+
+	function Setters:SetViewX (x)
+		self.widget:SetViewOrigin(x, 0)
+	end
+
+	function Setters:SetViewY (y)
+		self.widget:SetViewOrigin(0, y)
+	end
+
+	Setters.__index = Setters
+
+	-- Tween descriptors: setter, and initial origin in view sizes, per slide-in type --
+	local Tweens = { ["h+"] = { "SetViewX", 1 }, ["h-"] = { "SetViewX", -1 }, ["v+"] = { "SetViewY", -1 }, ["v-"] = { "SetViewY", 1 } }
+
 	-- Builds a view slide-in transition task
 	-- widget: Widget handle
 	-- duration: Transition duration
@@ -262,6 +438,18 @@ do
 	-- Returns: Task
 	------------------------------------------
 	function SlideViewIn (widget, duration, how, options)
+		-- Where possible, slide on the tween bank. The view size is taken once, up front.
+		if CanTween(options) then
+			local setter, from = unpack(Tweens[how])
+			local vw, vh = GetSize()
+
+			from = from * (setter == "SetViewX" and vw or vh)
+
+			return TweenTask({ { setmetatable({ widget = widget }, Setters), setter, from, 0 } }, duration, options, function()
+				assert(widget:IsAttached(), "Attempt to slide view of unattached widget")
+			end)
+		end
+
 		return InterpolatorTask(function(t)
 			assert(widget:IsAttached(), "Attempt to slide view of unattached widget")
 
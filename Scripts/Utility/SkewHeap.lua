@@ -9,7 +9,11 @@ local assert = assert
 local _L = {}
 local _R = {}
 
----
+--- This module defines skew heap operations over tables.<br><br>
+-- Heaps ordered by numeric priority may switch to the native <b>PriorityQueue</b> class,
+-- whose <b>Insert</b>, <b>Remove</b>, <b>IsEmpty</b>, and <b>Clear</b> methods mirror these
+-- operations, with priorities in place of order functions; it also supports updates and
+-- removals by handle, and bulk loads via <b>Heapify</b>.
 module "skew_heap"
 
 -- Merge function implementing a skew heap; outputs the root to r[_R]
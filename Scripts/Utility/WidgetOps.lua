@@ -2,6 +2,7 @@
 
 -- Standard library imports --
 local assert = assert
+local ipairs = ipairs
 local pairs = pairs
 local select = select
 local messagef = messagef
@@ -25,6 +26,9 @@ local SuperCons = class.SuperCons
 local Type = class.Type
 local Weak = table_ops.Weak
 
+-- Native signal dispatcher, unless disabled at boot --
+local Dispatch = UseNativeSignals ~= false and signal_dispatch
+
 --- An assortment of primitives useful in building widgets.
 module "widget_ops"
 
@@ -105,6 +109,20 @@ function AugmentSignal (O, how, signal, func, defcore)
 	return slot
 end
 
+--- Sends a signal to each of several Signalable objects, as per <b>Signalable:Signal</b>.
+-- @param objects Array of objects, visited in order.
+-- @param signal Non-<b>nil</b> signal name.
+-- @param ... Slot arguments.
+function SignalMany (objects, signal, ...)
+	if Dispatch then
+		Dispatch.SignalMany(objects, signal, ...)
+	else
+		for _, O in ipairs(objects) do
+			O:Signal(signal, ...)
+		end
+	end
+end
+
 --- Renders a widget that behaves like a button. This will draw one of these pictures with
 -- rect (x, y, w, h), based on the current widget state: <b>"main"</b>, <b>"grabbed"</b>,
 -- or <b>"entered"</b>.
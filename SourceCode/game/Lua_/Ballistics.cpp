@@ -0,0 +1,197 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Vec3Array.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <xmmintrin.h>
+
+using namespace Lua;
+
+/// Squared horizontal distance below which a shot is treated as vertical
+static const float kVertical = 1e-5f;
+
+/// Reads a per-pair parameter, given either as one number for all pairs or as an array
+/// @param index Stack index of parameter
+/// @param values [out] Parameter values, padded to the SIMD width
+/// @param count Count of pairs
+/// @remark Values must be positive, since the solutions divide by them
+static void GetParam (lua_State * L, int index, std::vector<float> & values, size_t count)
+{
+	values.resize((count + Vec3Array::eWidth - 1) & ~size_t(Vec3Array::eWidth - 1), 1.0f);
+
+	if (lua_istable(L, index))
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			lua_rawgeti(L, index, int(i + 1));	// ..., value
+
+			values[i] = F(L, -1);
+
+			lua_pop(L, 1);	// ...
+
+			luaL_argcheck(L, values[i] > 0.0f, index, "Non-positive value in array");
+		}
+	}
+
+	else
+	{
+		float value = F(L, index);
+
+		luaL_argcheck(L, value > 0.0f, index, "Non-positive value");
+
+		std::fill(values.begin(), values.begin() + count, value);
+	}
+}
+
+/// Solves one vertical shot, as per script_helpers's VerticalLaunch
+/// @param y Height of target relative to launch point
+/// @param g Gravity constant
+/// @param v0 Launch speed
+/// @param bHigh If @b true, solve for the second angle
+/// @param angle [out] Launch angle
+/// @param time [out] Flight time
+/// @return If @b true, the target can be hit
+static bool Vertical (float y, float g, float v0, bool bHigh, float & angle, float & time)
+{
+	float disc = v0 * v0 - 2.0f * g * y;
+
+	if (disc < 0.0f) return false;
+
+	float root = std::sqrt(disc);
+
+	angle = 3.14159265f / 2.0f;
+
+	// Targets at or below the launch point are always hit, the second time by firing
+	// straight down; otherwise, the times are going up and coming down.
+	if (y <= 0.0f)
+	{
+		if (bHigh) angle = -angle;
+
+		time = (bHigh ? root - v0 : v0 + root) / g;
+	}
+
+	else time = (bHigh ? v0 + root : v0 - root) / g;
+
+	return true;
+}
+
+/// Batch counterpart of script_helpers.GetLaunchAngles
+/// @remark Arguments: points, targets, gravity, v0[, arc[, get_times[, angles_out[, times_out]]]]
+/// @remark @e points and @e targets are Vec3Arrays of equal size, with z as the vertical axis
+/// @remark @e gravity and @e v0 are either numbers, shared by every pair, or arrays
+/// @remark @e arc is @b "low" (the default) or @b "high"
+/// @return Table of angles, with @b false for unreachable targets; if @e get_times is
+/// true, a table of flight times, likewise; and the count of reachable targets
+/// @remark Reachability is tested on four pairs at once, via the discriminant of the
+/// trajectory's quadratic, before any transcendental work is done. Angles are recovered
+/// as atan((v0^2 -+ sqrt(disc)) / (g * x)), and times as x * sqrt(1 + tan^2) / v0, which
+/// match the asin-based forms in the script version
+static int LaunchAngles (lua_State * L)
+{
+	Vec3Array & points = Types::Vec3Array_r(L, 1);
+	Vec3Array & targets = Types::Vec3Array_r(L, 2);
+
+	luaL_argcheck(L, points.mCount == targets.mCount, 2, "Array size mismatch");
+
+	size_t count = points.mCount;
+
+	std::vector<float> gravity, speed;
+
+	GetParam(L, 3, gravity, count);
+	GetParam(L, 4, speed, count);
+
+	const char * arcs[] = { "low", "high", 0 };
+
+	bool bHigh = luaL_checkoption(L, 5, "low", arcs) != 0;
+	bool bGetTimes = lua_toboolean(L, 6) != 0;
+
+	// Find the reachable pairs, along with the terms needed to finish them off.
+	std::vector<float> x2(points.Padded()), v2(points.Padded()), disc(points.Padded());
+	std::vector<int> masks;
+
+	for (size_t i = 0; i < count; i += Vec3Array::eWidth)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&targets.mX[i]), _mm_loadu_ps(&points.mX[i]));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&targets.mY[i]), _mm_loadu_ps(&points.mY[i]));
+		__m128 y = _mm_sub_ps(_mm_loadu_ps(&targets.mZ[i]), _mm_loadu_ps(&points.mZ[i]));
+		__m128 g = _mm_loadu_ps(&gravity[i]), v = _mm_loadu_ps(&speed[i]);
+
+		// disc = v^4 - g * (g * x^2 + 2 * y * v^2)
+		__m128 hx2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), vv = _mm_mul_ps(v, v);
+		__m128 inner = _mm_add_ps(_mm_mul_ps(g, hx2), _mm_mul_ps(_mm_add_ps(y, y), vv));
+		__m128 d = _mm_sub_ps(_mm_mul_ps(vv, vv), _mm_mul_ps(g, inner));
+
+		_mm_storeu_ps(&x2[i], hx2);
+		_mm_storeu_ps(&v2[i], vv);
+		_mm_storeu_ps(&disc[i], d);
+
+		// Vertical shots have their own test, so let them through here.
+		__m128 ok = _mm_or_ps(_mm_cmpge_ps(d, _mm_setzero_ps()), _mm_cmplt_ps(hx2, _mm_set1_ps(kVertical)));
+
+		masks.push_back(_mm_movemask_ps(ok));
+	}
+
+	// Solve the survivors.
+	PrepOutTable(L, 7, int(count));	// ..., angles
+
+	if (bGetTimes) PrepOutTable(L, 8, int(count));	// ..., angles, times
+
+	int angles = lua_gettop(L) - (bGetTimes ? 1 : 0), reachable = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float angle, time;
+		bool bHit = (masks[i / Vec3Array::eWidth] & (1 << (i % Vec3Array::eWidth))) != 0;
+
+		if (bHit && x2[i] < kVertical) bHit = Vertical(targets.mZ[i] - points.mZ[i], gravity[i], speed[i], bHigh, angle, time);
+
+		else if (bHit)
+		{
+			float x = std::sqrt(x2[i]), root = std::sqrt(disc[i]);
+			float tangent = (bHigh ? v2[i] + root : v2[i] - root) / (gravity[i] * x);
+
+			angle = std::atan(tangent);
+			time = x * std::sqrt(1.0f + tangent * tangent) / speed[i];
+		}
+
+		if (bHit)
+		{
+			lua_pushnumber(L, angle);	// ..., angles[, times], angle
+
+			++reachable;
+		}
+
+		else lua_pushboolean(L, false);	// ..., angles[, times], false
+
+		lua_rawseti(L, angles, int(i + 1));	// ..., angles = { ..., angle_or_false }[, times]
+
+		if (bGetTimes)
+		{
+			bHit ? lua_pushnumber(L, time) : lua_pushboolean(L, false);	// ..., angles, times, time_or_false
+
+			lua_rawseti(L, -2, int(i + 1));	// ..., angles, times = { ..., time_or_false }
+		}
+	}
+
+	lua_pushinteger(L, reachable);	// ..., angles[, times], reachable
+
+	return bGetTimes ? 3 : 2;
+}
+
+/// Registers the ballistics library
+int Bindings::open_ballistics (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "LaunchAngles", LaunchAngles },
+		{ 0, 0 }
+	};
+
+	Register(L, "ballistics", funcs);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+
+using namespace Lua;
+
+/// Shared pool of recycled coroutine threads
+/// @remark Only threads whose body returned normally are taken back: such a thread has no
+/// call frames left, so emptying its stack puts it back in the state of a new one, its stack
+/// already grown. Threads that died in an error, or that were abandoned while suspended,
+/// are left to the collector.
+/// @remark Idle threads live in the library environment's array part
+struct CoroutinePool {
+	int mIdle;	///< Threads retained
+	int mLowWater;	///< Fewest threads retained since the last shrink
+	int mLimit;	///< Maximum threads retained
+	double mCreated;///< Requests served by a new thread
+	double mReused;	///< Requests served from the pool
+	double mDiscards;	///< Returned threads not retained
+
+	CoroutinePool (void) : mIdle(0), mLowWater(0), mLimit(64), mCreated(0), mReused(0), mDiscards(0)
+	{
+	}
+};
+
+/// @return Pool state
+static CoroutinePool & Pool (lua_State * L)
+{
+	lua_getfield(L, LUA_ENVIRONINDEX, "state");	// ..., state
+
+	CoroutinePool * pool = (CoroutinePool *)lua_touserdata(L, -1);
+
+	lua_pop(L, 1);	// ...
+
+	return *pool;
+}
+
+/// Drops retained threads beyond a count
+static void Trim (lua_State * L, CoroutinePool & pool, int keep)
+{
+	for (; pool.mIdle > keep; --pool.mIdle)
+	{
+		lua_pushnil(L);	// ..., nil
+		lua_rawseti(L, LUA_ENVIRONINDEX, pool.mIdle);	// ...
+	}
+
+	if (pool.mLowWater > pool.mIdle) pool.mLowWater = pool.mIdle;
+}
+
+/// Drops all retained threads
+static int Clear (lua_State * L)
+{
+	Trim(L, Pool(L), 0);
+
+	return 0;
+}
+
+/// Supplies a thread, ready to run a body
+/// @remark Arguments: func
+/// @remark A retained thread is used if available; otherwise a new one is made
+/// @return Thread
+static int Get (lua_State * L)
+{
+	CoroutinePool & pool = Pool(L);
+
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+
+	lua_settop(L, 1);	// func
+
+	if (pool.mIdle > 0)
+	{
+		lua_rawgeti(L, LUA_ENVIRONINDEX, pool.mIdle);	// func, co
+		lua_pushnil(L);	// func, co, nil
+		lua_rawseti(L, LUA_ENVIRONINDEX, pool.mIdle--);	// func, co
+
+		if (pool.mLowWater > pool.mIdle) pool.mLowWater = pool.mIdle;
+
+		++pool.mReused;
+	}
+
+	else
+	{
+		lua_newthread(L);	// func, co
+
+		++pool.mCreated;
+	}
+
+	lua_State * co = lua_tothread(L, 2);
+
+	lua_pushvalue(L, 1);// func, co, func
+	lua_xmove(L, co, 1);// func, co
+
+	return 1;
+}
+
+/// @return Created, reused, discarded, and retained counts
+static int GetStats (lua_State * L)
+{
+	CoroutinePool & pool = Pool(L);
+
+	lua_pushnumber(L, pool.mCreated);	// created
+	lua_pushnumber(L, pool.mReused);// created, reused
+	lua_pushnumber(L, pool.mDiscards);	// created, reused, discards
+	lua_pushinteger(L, pool.mIdle);	// created, reused, discards, retained
+
+	return 4;
+}
+
+/// Returns a thread to the pool, if it finished cleanly and there is room
+/// @remark Arguments: co
+/// @return If true, the thread was retained
+static int Put (lua_State * L)
+{
+	CoroutinePool & pool = Pool(L);
+
+	lua_State * co = lua_tothread(L, 1);
+
+	luaL_argcheck(L, co != 0 && co != L, 1, "Expected a thread other than the caller");
+
+	// A thread is only reusable once its body returned: no error status and no frames.
+	lua_Debug ar;
+
+	bool bRetain = 0 == lua_status(co) && !lua_getstack(co, 0, &ar) && pool.mIdle < pool.mLimit;
+
+	if (bRetain)
+	{
+		lua_settop(co, 0);
+
+		lua_settop(L, 1);	// co
+		lua_rawseti(L, LUA_ENVIRONINDEX, ++pool.mIdle);	//
+	}
+
+	else ++pool.mDiscards;
+
+	lua_pushboolean(L, bRetain);// retained
+
+	return 1;
+}
+
+/// Sets the maximum number of threads retained, dropping any excess
+/// @remark Arguments: limit
+static int SetLimit (lua_State * L)
+{
+	CoroutinePool & pool = Pool(L);
+
+	pool.mLimit = luaL_checkint(L, 1);
+
+	if (pool.mLimit < 0) pool.mLimit = 0;
+
+	Trim(L, pool, pool.mLimit);
+
+	return 0;
+}
+
+/// Drops the threads that went unused since the previous shrink, i.e. the fewest retained
+/// at any point in between, which the pool was evidently able to spare
+/// @return Number of threads dropped
+static int Shrink (lua_State * L)
+{
+	CoroutinePool & pool = Pool(L);
+
+	int count = pool.mLowWater;
+
+	Trim(L, pool, pool.mIdle - count);
+
+	pool.mLowWater = pool.mIdle;
+
+	lua_pushinteger(L, count);	// count
+
+	return 1;
+}
+
+/// Registers the coroutine_pool library
+int Bindings::open_coroutinepool (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Clear", Clear },
+		{ "Get", Get },
+		{ "GetStats", GetStats },
+		{ "Put", Put },
+		{ "SetLimit", SetLimit },
+		{ "Shrink", Shrink },
+		{ 0, 0 }
+	};
+
+	// Build the environment: the pool state, with idle threads to follow.
+	lua_createtable(L, 0, 1);	// env
+
+	new (lua_newuserdata(L, sizeof(CoroutinePool))) CoroutinePool;	// env, state
+
+	lua_setfield(L, -2, "state");	// env = { state = state }
+
+	Register(L, "coroutine_pool", funcs, -1);
+
+	lua_pop(L, 1);
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include <cstring>
+
+using namespace Lua;
+
+/// Calls a function on the stack with copies of a run of arguments
+/// @param first Stack index of first argument
+/// @param last Stack index of last argument
+/// @param nresults Result count, as per lua_call
+static void CallWithArgs (lua_State * L, int first, int last, int nresults)
+{
+	for (int i = first; i <= last; ++i) lua_pushvalue(L, i);// ..., func, ...
+
+	lua_call(L, last - first + 1, nresults);// ...[, results]
+}
+
+/// Runs a delegate's call chain: its "before" functions, most recent first, then the core,
+/// then its "after" functions, in the order added, each with the call arguments
+/// @remark Arguments: core, befores, afters, can_abort, ...
+/// @remark The core's results stay on the stack while the "after" functions run, so no table
+/// is needed to hold them
+/// @return Core results; nothing, if a "before" function aborted the call
+static int Invoke (lua_State * L)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+	luaL_checktype(L, 3, LUA_TTABLE);
+
+	bool bCanAbort = lua_toboolean(L, 4) != 0;
+	int top = lua_gettop(L);
+
+	luaL_checkstack(L, top, "Too many arguments");
+
+	// Invoke each before routine, aborting if requested.
+	for (int i = int(lua_objlen(L, 2)); i > 0; --i)
+	{
+		lua_rawgeti(L, 2, i);	// core, befores, afters, can_abort, ..., before
+
+		CallWithArgs(L, 5, top, 1);	// core, befores, afters, can_abort, ..., result
+
+		size_t len;
+
+		const char * result = lua_type(L, -1) == LUA_TSTRING ? lua_tolstring(L, -1, &len) : 0;
+
+		if (bCanAbort && result && 5 == len && 0 == memcmp(result, "abort", 5)) return 0;
+
+		lua_pop(L, 1);	// core, befores, afters, can_abort, ...
+	}
+
+	// Invoke the core, leaving its results in place.
+	lua_pushvalue(L, 1);// core, befores, afters, can_abort, ..., core
+
+	CallWithArgs(L, 5, top, LUA_MULTRET);	// core, befores, afters, can_abort, ..., results
+
+	int nresults = lua_gettop(L) - top;
+
+	// Invoke each after routine.
+	luaL_checkstack(L, top, "Too many results");
+
+	for (int i = 1; ; ++i)
+	{
+		lua_rawgeti(L, 3, i);	// core, befores, afters, can_abort, ..., results, after?
+
+		if (lua_isnil(L, -1)) break;
+
+		CallWithArgs(L, 5, top, 0);	// core, befores, afters, can_abort, ..., results
+	}
+
+	lua_pop(L, 1);	// core, befores, afters, can_abort, ..., results
+
+	return nresults;
+}
+
+/// Registers the delegate_ops library
+int Bindings::open_delegateops (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Invoke", Invoke },
+		{ 0, 0 }
+	};
+
+	Register(L, "delegate_ops", funcs);
+
+	return 0;
+}
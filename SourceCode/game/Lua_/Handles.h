@@ -0,0 +1,261 @@
+#ifndef LUA_HANDLES_H
+#define LUA_HANDLES_H
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include <vector>
+
+namespace Lua
+{
+	/*%%%%%%%%%%%%%%%% HANDLES %%%%%%%%%%%%%%%%*/
+
+	/// Reference to an object in a HandleTable
+	/// @remark Of all the handles to an object, only the one made with it owns it; copies
+	/// are plain references, and go stale once the object is retired
+	struct Handle {
+		unsigned int mSlot;	///< Slot index
+		unsigned int mGeneration;	///< Slot generation when handle was issued
+		bool bOwner;///< If true, collecting the handle retires the object
+	};
+
+	/// Templated object retirement, once an object leaves its table
+	/// @param object Object to retire
+	/// @remark Reference-counted types should specialize this to call Release()
+	template<typename T> void luaT_handle_retire (T * object)
+	{
+		delete object;
+	}
+
+	/// Per-type object table addressed by handles
+	/// @remark Objects are kept densely packed, so batch code may walk them directly
+	/// @remark The table owns each object until it is removed, so copying a handle involves
+	/// no reference count traffic; a handle whose object was removed is stale
+	template<typename T> class HandleTable {
+		/// Slot, mapping a handle to its object's dense index
+		struct Slot {
+			unsigned int mDense;///< Dense index, or next free slot when unused
+			unsigned int mGeneration;	///< Current generation; bumped on removal
+		};
+
+		std::vector<T *> mObjects;	///< Dense object array
+		std::vector<unsigned int> mOwners;	///< Owning slot of each dense object
+		std::vector<Slot> mSlots;	///< Slot array
+		unsigned int mFree;	///< Head of free slot list
+
+		enum { eNone = ~0U };
+
+	public:
+		HandleTable (void) : mFree(eNone) {}
+
+		~HandleTable (void)
+		{
+			for (size_t i = 0; i < mObjects.size(); ++i) luaT_handle_retire(mObjects[i]);
+		}
+
+		/// Adds an object to the table, which takes ownership of it
+		/// @param object Object to add
+		/// @return Handle to object, marked as its owner
+		Handle Add (T * object)
+		{
+			Handle handle;
+
+			if (mFree != eNone)
+			{
+				handle.mSlot = mFree;
+
+				mFree = mSlots[mFree].mDense;
+			}
+
+			else
+			{
+				Slot slot = { 0, 0 };
+
+				handle.mSlot = (unsigned int)mSlots.size();
+
+				mSlots.push_back(slot);
+			}
+
+			mSlots[handle.mSlot].mDense = (unsigned int)mObjects.size();
+
+			handle.mGeneration = mSlots[handle.mSlot].mGeneration;
+			handle.bOwner = true;
+
+			mObjects.push_back(object);
+			mOwners.push_back(handle.mSlot);
+
+			return handle;
+		}
+
+		/// Looks up an object
+		/// @param handle Object handle
+		/// @return Object, or @b NULL if the handle is stale
+		T * Get (const Handle & handle) const
+		{
+			if (!IsValid(handle)) return 0;
+
+			return mObjects[mSlots[handle.mSlot].mDense];
+		}
+
+		/// @param handle Object handle
+		/// @return If @b true, the handle refers to a live object
+		bool IsValid (const Handle & handle) const
+		{
+			return handle.mSlot < mSlots.size() && mSlots[handle.mSlot].mGeneration == handle.mGeneration;
+		}
+
+		/// Removes an object from the table and retires it
+		/// @param handle Object handle
+		/// @return If @b true, the handle was valid
+		/// @remark The last dense object is moved into the vacated position
+		bool Remove (const Handle & handle)
+		{
+			if (!IsValid(handle)) return false;
+
+			Slot & slot = mSlots[handle.mSlot];
+			T * object = mObjects[slot.mDense];
+			unsigned int last = (unsigned int)mObjects.size() - 1;
+
+			mObjects[slot.mDense] = mObjects[last];
+			mOwners[slot.mDense] = mOwners[last];
+			mSlots[mOwners[last]].mDense = slot.mDense;
+
+			mObjects.pop_back();
+			mOwners.pop_back();
+
+			// Invalidate outstanding handles and recycle the slot.
+			++slot.mGeneration;
+
+			slot.mDense = mFree;
+
+			mFree = handle.mSlot;
+
+			luaT_handle_retire(object);
+
+			return true;
+		}
+
+		/// @return Count of live objects
+		size_t Count (void) const { return mObjects.size(); }
+
+		/// @return Pointer to dense object array, valid until the next Add() or Remove()
+		T ** Objects (void) { return mObjects.empty() ? 0 : &mObjects[0]; }
+	};
+
+	/*%%%%%%%%%%%%%%%% TEMPLATED HANDLE FUNCTIONS %%%%%%%%%%%%%%%%*/
+
+	/// Templated handle type stub
+	/// @return Empty string
+	template<typename T> const char * luaT_handle_type (void) { return ""; }
+
+	/// Templated handle table accessor
+	/// @return Table of objects of type T
+	template<typename T> HandleTable<T> & luaT_handle_table (void)
+	{
+		static HandleTable<T> sTable;
+
+		return sTable;
+	}
+
+	/// Templated handle member get
+	/// @param source
+	/// @return Object, or @b NULL if the handle is stale
+	template<typename T> T * luaT_handle_get (lua_State * L, int source)
+	{
+		return luaT_handle_table<T>().Get(*(Handle *)UD(L, source));
+	}
+
+	/// Templated handle member get, erroring on stale handles
+	/// @param source
+	/// @return Object
+	template<typename T> T * luaT_handle_check (lua_State * L, int source)
+	{
+		T * object = luaT_handle_get<T>(L, source);
+
+		if (0 == object) luaL_error(L, "Arg #%d: stale %s handle", source, luaT_handle_type<T>());
+
+		return object;
+	}
+
+	/// Templated handle lookup stub, for types without handles
+	/// @return @b NULL
+	/// @remark Types with handles get a real lookup via LUAT_HANDLE_TYPE
+	template<typename T> T * luaT_handle_ptr (lua_State * L, int index) { return 0; }
+
+	/// Templated handle member direct set
+	/// @param dest
+	/// @param handle
+	/// @param bOwner If @b true, the destination owns the object
+	template<typename T> int luaT_handle_set (lua_State * L, int dest, const Handle & handle, bool bOwner)
+	{
+		Handle * target = (Handle *)UD(L, dest);
+
+		*target = handle;
+
+		target->bOwner = bOwner;
+
+		return 0;
+	}
+
+	/// Templated handle member set
+	/// @param dest
+	/// @param source
+	/// @remark No reference count traffic: only the handle is copied, and the copy does
+	/// not own the object
+	template<typename T> int luaT_handle_set (lua_State * L, int dest, int source)
+	{
+		return luaT_handle_set<T>(L, dest, *(Handle *)UD(L, source), false);
+	}
+
+	/// Templated @b __cons metamethod (handle version)
+	/// @remark Note that this adheres to the @b lua_CFunction signature
+	template<typename T> int luaT_cons_handle (lua_State * L)
+	{
+		return luaT_handle_set<T>(L, 1, luaT_handle_table<T>().Add(new T), true);
+	}
+
+	/// Templated copy @b __cons metamethod (handle version)
+	/// @remark Note that this adheres to the @b lua_CFunction signature
+	template<typename T> int luaT_cons_handle_copy (lua_State * L)
+	{
+		return luaT_handle_set<T>(L, 1, 2);
+	}
+
+	/// Templated @b __gc metamethod (handle version); an owning handle retires its object,
+	/// if still live, and any copies go stale
+	/// @remark Note that this adheres to the @b lua_CFunction signature
+	template<typename T> int luaT_gc_handle (lua_State * L)
+	{
+		Handle * handle = (Handle *)UD(L, 1);
+
+		if (handle->bOwner) luaT_handle_table<T>().Remove(*handle);
+
+		return 0;
+	}
+
+	/// Templated object removal (handle version), retiring the object through any of its
+	/// handles; all of them go stale
+	/// @remark Note that this adheres to the @b lua_CFunction signature
+	template<typename T> int luaT_handle_remove (lua_State * L)
+	{
+		lua_pushboolean(L, luaT_handle_table<T>().Remove(*(Handle *)UD(L, 1)));	// handle, removed
+
+		return 1;
+	}
+
+	/// Templated handle validity test
+	/// @remark Note that this adheres to the @b lua_CFunction signature
+	template<typename T> int luaT_handle_is_valid (lua_State * L)
+	{
+		lua_pushboolean(L, luaT_handle_table<T>().IsValid(*(Handle *)UD(L, 1)));	// handle, valid
+
+		return 1;
+	}
+}
+
+/// Gives a type a handle representation, hooking it into Lua::luaT_ptr()
+/// @remark Must appear within namespace Lua
+#define LUAT_HANDLE_TYPE(type, name)														\
+	template<> const char * luaT_handle_type<type> (void) { return name; }					\
+	template<> type * luaT_handle_ptr<type> (lua_State * L, int index) { return luaT_handle_check<type>(L, index); }
+
+#endif // LUA_HANDLES_H
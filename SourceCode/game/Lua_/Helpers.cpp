@@ -294,6 +294,27 @@ namespace Lua
 		lua_rawseti(L, index, top);	// [top]
 	}
 
+	/// Gets a table to receive results, making one if absent
+	/// @param index Stack index of optional results table; if not a table, a new one is made
+	/// @param count Count of array entries about to be written; any entries beyond this in
+	/// an existing table are cleared
+	/// @remark Results table left on stack
+	void PrepOutTable (lua_State * L, int index, int count)
+	{
+		if (lua_istable(L, index))
+		{
+			lua_pushvalue(L, index);// ..., out
+
+			for (int i = GetN(L, -1); i > count; --i)
+			{
+				lua_pushnil(L);	// ..., out, nil
+				lua_rawseti(L, -2, i);	// ..., out = { ..., [i] = nil }
+			}
+		}
+
+		else lua_createtable(L, count, 0);	// ..., out
+	}
+
 	/// Pushes the top stack element onto the end of a table
 	/// @param index Table stack index
 	void Push (lua_State * L, int index)
@@ -44,6 +44,7 @@ namespace Lua
 	G2GAME_IMPEXP void CacheAndGet (lua_State * L, lua_CFunction func);
 	G2GAME_IMPEXP void GetGlobal (lua_State * L, const char * name);
 	G2GAME_IMPEXP void Pop (lua_State * L, int index, bool bPutOnStack = false);
+	G2GAME_IMPEXP void PrepOutTable (lua_State * L, int index, int count);
 	G2GAME_IMPEXP void Push (lua_State * L, int index);
 	G2GAME_IMPEXP void Register (lua_State * L, const char * name, const luaL_reg * funcs, int env = 0);
 	G2GAME_IMPEXP void SetGlobal (lua_State * L, const char * name);
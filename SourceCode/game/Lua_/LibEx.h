@@ -7,7 +7,25 @@
 
 namespace Bindings
 {
+	G2GAME_IMPEXP int open_ballistics (lua_State * L);
+	G2GAME_IMPEXP int open_coroutinepool (lua_State * L);
+	G2GAME_IMPEXP int open_delegateops (lua_State * L);
+	G2GAME_IMPEXP int open_orderedset (lua_State * L);
+	G2GAME_IMPEXP int open_orderlessarray (lua_State * L);
+	G2GAME_IMPEXP int open_priorityqueue (lua_State * L);
+	G2GAME_IMPEXP int open_signaldispatch (lua_State * L);
 	G2GAME_IMPEXP int open_std (lua_State * L);
+	G2GAME_IMPEXP int open_spatialgrid (lua_State * L);
+	G2GAME_IMPEXP int open_tableops (lua_State * L);
+	G2GAME_IMPEXP int open_tablepool (lua_State * L);
+	G2GAME_IMPEXP int open_taskpost (lua_State * L);
+	G2GAME_IMPEXP int open_timerbank (lua_State * L);
+	G2GAME_IMPEXP int open_timerwheel (lua_State * L);
+	G2GAME_IMPEXP int open_timing (lua_State * L);
+	G2GAME_IMPEXP int open_tweenbank (lua_State * L);
+	G2GAME_IMPEXP int open_varpreds (lua_State * L);
+	G2GAME_IMPEXP int open_varstore (lua_State * L);
+	G2GAME_IMPEXP int open_vec3array (lua_State * L);
 }
 
 namespace Lua
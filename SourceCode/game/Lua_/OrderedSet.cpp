@@ -0,0 +1,583 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <cstring>
+#include <vector>
+
+using namespace Lua;
+
+/// Identity of a Lua value, as used for table keys
+struct ValueKey {
+	int mType;	///< Lua type
+	union {
+		const void * mPointer;	///< Object or interned string address
+		double mNumber;	///< Number or boolean value
+	};
+
+	/// @return If @b true, the keys refer to the same value
+	bool operator == (const ValueKey & other) const
+	{
+		if (mType != other.mType) return false;
+
+		if (LUA_TNUMBER == mType || LUA_TBOOLEAN == mType) return mNumber == other.mNumber;
+
+		return mPointer == other.mPointer;
+	}
+
+	/// @return Hash of the key
+	size_t Hash (void) const
+	{
+		size_t bits = 0;
+
+		if (LUA_TNUMBER == mType || LUA_TBOOLEAN == mType)
+		{
+			unsigned int words[sizeof(double) / sizeof(unsigned int)];
+
+			memcpy(words, &mNumber, sizeof(double));
+
+			for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) bits = bits * 31 + words[i];
+		}
+
+		else bits = size_t(mPointer) >> 3;
+
+		return (bits ^ (bits >> 16)) * 0x45d9f3b;
+	}
+};
+
+/// Ordered set over dense storage
+/// @remark Entries are linked by slot index, so placement and removal are O(1); removed
+/// slots are left as tombstones until they outnumber the live ones, at which point the
+/// slots are compacted in list order
+/// @remark Slot values live in a table in the set's environment
+struct OrderedSet {
+	enum { eEmpty = 0, eDeleted = -1 };
+
+	std::vector<ValueKey> mKeys;///< Per-slot value keys
+	std::vector<int> mPrev;	///< Per-slot previous slot, or -1
+	std::vector<int> mNext;	///< Per-slot next slot, or -1
+	std::vector<int> mIndex;///< Open-addressed index: slot + 1, eEmpty, or eDeleted
+	size_t mCount;	///< Count of live entries
+	size_t mMarked;	///< Count of non-empty index cells, deleted ones included
+	int mFront;	///< Front slot, or -1
+	int mBack;	///< Back slot, or -1
+
+	OrderedSet (void) : mIndex(8, eEmpty), mCount(0), mMarked(0), mFront(-1), mBack(-1) {}
+
+	/// Looks up a value
+	/// @return Slot index, or -1 if absent
+	int Find (const ValueKey & key) const
+	{
+		size_t mask = mIndex.size() - 1;
+
+		for (size_t i = key.Hash() & mask; ; i = (i + 1) & mask)
+		{
+			int cell = mIndex[i];
+
+			if (eEmpty == cell) return -1;
+
+			if (cell > 0 && mKeys[cell - 1] == key) return cell - 1;
+		}
+	}
+
+	/// Adds a slot to the index, which is assumed not to hold it
+	void Index (int slot)
+	{
+		if ((mMarked + 1) * 2 > mIndex.size()) Reindex(mCount * 4 > mIndex.size() ? mIndex.size() * 2 : mIndex.size());
+
+		size_t mask = mIndex.size() - 1, i = mKeys[slot].Hash() & mask;
+
+		while (mIndex[i] > 0) i = (i + 1) & mask;
+
+		if (eEmpty == mIndex[i]) ++mMarked;
+
+		mIndex[i] = slot + 1;
+	}
+
+	/// Removes a slot from the index
+	void Unindex (int slot)
+	{
+		size_t mask = mIndex.size() - 1;
+
+		for (size_t i = mKeys[slot].Hash() & mask; ; i = (i + 1) & mask)
+		{
+			if (mIndex[i] == slot + 1)
+			{
+				mIndex[i] = eDeleted;
+
+				return;
+			}
+		}
+	}
+
+	/// Rebuilds the index from the live slots, dropping deleted cells
+	/// @param size Index size, a power of 2
+	void Reindex (size_t size)
+	{
+		mIndex.assign(size, eEmpty);
+
+		mMarked = 0;
+
+		for (int slot = mFront; slot != -1; slot = mNext[slot]) Index(slot);
+	}
+
+	/// Detaches a slot from its neighbors
+	void Unlink (int slot)
+	{
+		int prev = mPrev[slot], next = mNext[slot];
+
+		(prev != -1 ? mNext[prev] : mFront) = next;
+		(next != -1 ? mPrev[next] : mBack) = prev;
+	}
+
+	/// Attaches a slot after another
+	/// @param prev Slot to follow, or -1 to become the front
+	void LinkAfter (int prev, int slot)
+	{
+		int next = prev != -1 ? mNext[prev] : mFront;
+
+		mPrev[slot] = prev;
+		mNext[slot] = next;
+
+		(prev != -1 ? mNext[prev] : mFront) = slot;
+		(next != -1 ? mPrev[next] : mBack) = slot;
+	}
+
+	/// Attaches a slot before another
+	/// @param next Slot to precede, or -1 to become the back
+	void LinkBefore (int next, int slot)
+	{
+		LinkAfter(next != -1 ? mPrev[next] : mBack, slot);
+	}
+};
+
+namespace Lua
+{
+	/// OrderedSet type name
+	template<> const char * luaT_type<OrderedSet> (void) { return "OrderedSet"; }
+}
+
+/// Dummy variable; the value table is stored in the environment under its address
+static int _values;
+
+/// @return Set at index 1
+/// @remark Value table left on stack
+static OrderedSet & Set (lua_State * L)
+{
+	OrderedSet & S = luaT_ref<OrderedSet>(L, 1);
+
+	lua_getfenv(L, 1);	// S, ..., env
+	lua_pushlightuserdata(L, &_values);	// S, ..., env, key
+	lua_rawget(L, -2);	// S, ..., env, values
+	lua_replace(L, -2);	// S, ..., values
+
+	return S;
+}
+
+/// Gets the identity of a value
+/// @param index Stack index of value
+/// @param key [out] Value key
+/// @return If @b false, the value is @b nil
+static bool GetKey (lua_State * L, int index, ValueKey & key)
+{
+	key.mType = lua_type(L, index);
+
+	switch (key.mType)
+	{
+	case LUA_TNIL:
+	case LUA_TNONE:
+		return false;
+	case LUA_TNUMBER:
+		key.mNumber = lua_tonumber(L, index);
+
+		if (key.mNumber != key.mNumber) luaL_error(L, "Cannot use NaN entries");
+
+		if (0.0 == key.mNumber) key.mNumber = 0.0;	// Fold -0 into 0
+		break;
+	case LUA_TBOOLEAN:
+		key.mNumber = lua_toboolean(L, index);
+		break;
+	case LUA_TSTRING:
+		key.mPointer = lua_tostring(L, index);	// Strings are interned
+		break;
+	default:
+		key.mPointer = lua_topointer(L, index);
+	}
+
+	return true;
+}
+
+/// @param index Stack index of value
+/// @return Slot of value, or -1 if absent
+static int Find (lua_State * L, OrderedSet & S, int index)
+{
+	ValueKey key;
+
+	return GetKey(L, index, key) ? S.Find(key) : -1;
+}
+
+/// Pushes a slot's value, or @b nil for no slot
+/// @param values Stack index of value table
+static void PushSlot (lua_State * L, int values, int slot)
+{
+	if (slot != -1) lua_rawgeti(L, values, slot + 1);	// ..., value
+
+	else lua_pushnil(L);// ..., nil
+}
+
+/// Compacts the slots in list order, if tombstones have piled up
+/// @param values Stack index of value table
+static void MaybeCompact (lua_State * L, OrderedSet & S, int values)
+{
+	size_t dead = S.mKeys.size() - S.mCount;
+
+	if (dead < 16 || dead < S.mCount) return;
+
+	std::vector<ValueKey> keys;
+
+	keys.reserve(S.mCount);
+
+	lua_getfenv(L, 1);	// ..., env
+	lua_pushlightuserdata(L, &_values);	// ..., env, key
+	lua_createtable(L, int(S.mCount), 0);	// ..., env, key, new_values
+
+	for (int slot = S.mFront; slot != -1; slot = S.mNext[slot])
+	{
+		keys.push_back(S.mKeys[slot]);
+
+		lua_rawgeti(L, values, slot + 1);	// ..., env, key, new_values, value
+		lua_rawseti(L, -2, int(keys.size()));	// ..., env, key, new_values = { ..., value }
+	}
+
+	lua_pushvalue(L, -1);	// ..., env, key, new_values, new_values
+	lua_replace(L, values);	// ..., env, key, new_values
+	lua_rawset(L, -3);	// ..., env = { ..., [key] = new_values }
+	lua_pop(L, 1);	// ...
+
+	int n = int(keys.size());
+
+	S.mKeys.swap(keys);
+	S.mPrev.resize(n);
+	S.mNext.resize(n);
+
+	for (int i = 0; i < n; ++i)
+	{
+		S.mPrev[i] = i - 1;
+		S.mNext[i] = i + 1 < n ? i + 1 : -1;
+	}
+
+	S.mFront = n > 0 ? 0 : -1;
+	S.mBack = n - 1;
+
+	S.Reindex(S.mIndex.size());
+}
+
+/// @remark Arguments: entry
+/// @return If @b true, @e entry is in the set
+static int Contains (lua_State * L)
+{
+	OrderedSet & S = luaT_ref<OrderedSet>(L, 1);
+
+	lua_pushboolean(L, Find(L, S, 2) != -1);// S, entry, bContains
+
+	return 1;
+}
+
+/// Removes an entry, if present, from the set
+/// @remark Arguments: entry
+/// @return If @b true, @e entry was in the set
+static int Remove (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	OrderedSet & S = Set(L);// S, entry, values
+
+	int slot = Find(L, S, 2);
+
+	if (slot != -1)
+	{
+		S.Unlink(slot);
+		S.Unindex(slot);
+
+		S.mPrev[slot] = S.mNext[slot] = -1;
+
+		--S.mCount;
+
+		lua_pushnil(L);	// S, entry, values, nil
+		lua_rawseti(L, 3, slot + 1);// S, entry, values
+
+		MaybeCompact(L, S, 3);
+	}
+
+	lua_pushboolean(L, slot != -1);	// S, entry, values, bRemoved
+
+	return 1;
+}
+
+/// Adds an entry, or detaches it if already present
+/// @param values Stack index of value table
+/// @param entry Stack index of entry
+/// @return Entry's slot, unlinked
+static int Claim (lua_State * L, OrderedSet & S, int values, int entry)
+{
+	ValueKey key;
+
+	if (!GetKey(L, entry, key)) luaL_error(L, "Cannot add nil entries");
+
+	int slot = S.Find(key);
+
+	if (slot != -1) S.Unlink(slot);
+
+	else
+	{
+		slot = int(S.mKeys.size());
+
+		S.mKeys.push_back(key);
+		S.mPrev.push_back(-1);
+		S.mNext.push_back(-1);
+
+		S.Index(slot);
+
+		++S.mCount;
+
+		lua_pushvalue(L, entry);// ..., entry
+		lua_rawseti(L, values, slot + 1);	// ...
+	}
+
+	return slot;
+}
+
+/// Common body for PutAfter() and PutBefore()
+/// @param bAfter If @b true, put after the referent
+static int Put (lua_State * L, bool bAfter)
+{
+	lua_settop(L, 3);
+
+	OrderedSet & S = Set(L);// S, ref, entry, values
+
+	ValueKey rkey, ekey;
+
+	bool bHasRef = GetKey(L, 2, rkey);
+
+	if (GetKey(L, 3, ekey) && bHasRef && rkey == ekey) luaL_error(L, bAfter ? "Cannot put entry after self" : "Cannot put entry before self");
+
+	int ref = bHasRef ? S.Find(rkey) : -1;
+
+	if (bHasRef && -1 == ref) luaL_error(L, bAfter ? "prev is not in the set" : "next is not in the set");
+
+	int slot = Claim(L, S, 4, 3);
+
+	bAfter ? S.LinkAfter(ref, slot) : S.LinkBefore(ref, slot);
+
+	return 0;
+}
+
+/// Puts an entry after another in the set
+/// @remark Arguments: prev, entry
+/// @remark If @e prev is @b nil, @e entry becomes the front
+static int PutAfter (lua_State * L)
+{
+	return Put(L, true);
+}
+
+/// Puts an entry before another in the set
+/// @remark Arguments: next, entry
+/// @remark If @e next is @b nil, @e entry becomes the back
+static int PutBefore (lua_State * L)
+{
+	return Put(L, false);
+}
+
+/// Adds or moves an entry to the back of the set
+/// @remark Arguments: entry
+static int PutInBack (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	OrderedSet & S = Set(L);// S, entry, values
+
+	S.LinkBefore(-1, Claim(L, S, 3, 2));
+
+	return 0;
+}
+
+/// Adds or moves an entry to the front of the set
+/// @remark Arguments: entry
+static int PutInFront (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	OrderedSet & S = Set(L);// S, entry, values
+
+	S.LinkAfter(-1, Claim(L, S, 3, 2));
+
+	return 0;
+}
+
+/// @return Back entry, or @b nil if the set is empty
+static int Back (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	OrderedSet & S = Set(L);// S, values
+
+	PushSlot(L, 2, S.mBack);// S, values, back
+
+	return 1;
+}
+
+/// @return Front entry, or @b nil if the set is empty
+static int Front (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	OrderedSet & S = Set(L);// S, values
+
+	PushSlot(L, 2, S.mFront);	// S, values, front
+
+	return 1;
+}
+
+/// Common body for Next() and Prev()
+/// @param bNext If @b true, step toward the back
+static int Step (lua_State * L, bool bNext)
+{
+	lua_settop(L, 3);
+
+	OrderedSet & S = Set(L);// S, entry, loop, values
+
+	int slot = Find(L, S, 2), to = -1;
+
+	if (slot != -1)
+	{
+		to = bNext ? S.mNext[slot] : S.mPrev[slot];
+
+		if (-1 == to && lua_toboolean(L, 3)) to = bNext ? S.mFront : S.mBack;
+	}
+
+	PushSlot(L, 4, to);	// S, entry, loop, values, entry_or_nil
+
+	return 1;
+}
+
+/// @remark Arguments: entry[, loop]
+/// @return Entry after @e entry, or @b nil if @e entry is not in the set; if @e loop is
+/// true, the back is followed by the front
+static int Next (lua_State * L)
+{
+	return Step(L, true);
+}
+
+/// @remark Arguments: entry[, loop]
+/// @return Entry before @e entry, or @b nil if @e entry is not in the set; if @e loop is
+/// true, the front is preceded by the back
+static int Prev (lua_State * L)
+{
+	return Step(L, false);
+}
+
+/// Common iterator body
+/// @param bForward If @b true, iterate front-to-back
+static int Iter (lua_State * L, bool bForward)
+{
+	if (lua_isnil(L, 2))
+	{
+		lua_settop(L, 1);
+
+		OrderedSet & S = Set(L);// S, values
+
+		PushSlot(L, 2, bForward ? S.mFront : S.mBack);	// S, values, entry
+
+		return 1;
+	}
+
+	lua_pushnil(L);	// S, entry, nil
+
+	return Step(L, bForward);
+}
+
+/// Back-to-front iterator body
+static int BackToFrontBody (lua_State * L)
+{
+	return Iter(L, false);
+}
+
+/// Front-to-back iterator body
+static int FrontToBackBody (lua_State * L)
+{
+	return Iter(L, true);
+}
+
+/// Iterates back-to-front over the set
+/// @return Iterator, which returns an entry at each iteration
+static int BackToFrontIter (lua_State * L)
+{
+	lua_pushcfunction(L, BackToFrontBody);	// S, body
+	lua_pushvalue(L, 1);// S, body, S
+
+	return 2;
+}
+
+/// Iterates front-to-back over the set
+/// @return Iterator, which returns an entry at each iteration
+static int FrontToBackIter (lua_State * L)
+{
+	lua_pushcfunction(L, FrontToBackBody);	// S, body
+	lua_pushvalue(L, 1);// S, body, S
+
+	return 2;
+}
+
+/// Metamethod
+/// @return Set size
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(luaT_ref<OrderedSet>(L, 1).mCount));	// S, count
+
+	return 1;
+}
+
+/// Constructor
+static int Cons (lua_State * L)
+{
+	new (UD(L, 1)) OrderedSet;
+
+	lua_getfenv(L, 1);	// S, ..., env
+	lua_pushlightuserdata(L, &_values);	// S, ..., env, key
+	lua_newtable(L);// S, ..., env, key, {}
+	lua_rawset(L, -3);	// S, ..., env = { [key] = {} }
+
+	return 0;
+}
+
+/// Binds the OrderedSet class
+/// @remark This must be done before the scripts are loaded, in which case it supersedes
+/// the script version
+int Bindings::open_orderedset (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Back", Back },
+		{ "BackToFrontIter", BackToFrontIter },
+		{ "Contains", Contains },
+		{ "Front", Front },
+		{ "FrontToBackIter", FrontToBackIter },
+		{ "Next", Next },
+		{ "Prev", Prev },
+		{ "PutAfter", PutAfter },
+		{ "PutBefore", PutBefore },
+		{ "PutInBack", PutInBack },
+		{ "PutInFront", PutInFront },
+		{ "Remove", Remove },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<OrderedSet> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "OrderedSet", methods, Class::Def(sizeof(OrderedSet)));
+
+	return 0;
+}
\ No newline at end of file
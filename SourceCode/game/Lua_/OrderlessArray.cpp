@@ -0,0 +1,520 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <algorithm>
+#include <vector>
+
+using namespace Lua;
+
+/// Array whose removals swap the back element into the vacancy
+/// @remark Elements and extras live in tables in the array's environment
+/// @remark Running iterators are tracked as cursors, each stamped with a generation so that
+/// a stale iterator can never act on a cursor that has since been reused
+struct OrderlessArray {
+	/// Running iterator state
+	struct Cursor {
+		unsigned mStamp;///< Generation of iterator using the cursor; 0 if free
+		int mNext;	///< Next index to visit
+	};
+
+	std::vector<Cursor> mCursors;	///< Cursors, in use or free
+	std::vector<int> mScratch;	///< Cursor indices, sorted during removal
+	std::vector<int> mMoves;///< Planned moves, reused across removals
+	unsigned mGeneration;	///< Last stamp handed out
+	int mCount;	///< Element count
+	int mExtraCount;///< Extra element count
+	bool mBusy;	///< If true, a batch removal is underway
+
+	OrderlessArray (void) : mGeneration(0), mCount(0), mExtraCount(0), mBusy(false) {}
+
+	/// Claims a cursor for a new iterator
+	/// @param stamp [out] Iterator's stamp
+	/// @return Cursor index
+	int Acquire (unsigned & stamp)
+	{
+		size_t index = 0;
+
+		while (index < mCursors.size() && mCursors[index].mStamp != 0) ++index;
+
+		if (index == mCursors.size()) mCursors.push_back(Cursor());
+
+		if (0 == ++mGeneration) ++mGeneration;	// Reserve 0 for free cursors
+
+		mCursors[index].mStamp = stamp = mGeneration;
+		mCursors[index].mNext = 1;
+
+		return int(index);
+	}
+
+	/// @return Cursor, or @b 0 if the stamp has gone stale
+	Cursor * Get (int index, unsigned stamp)
+	{
+		if (index < 0 || size_t(index) >= mCursors.size() || mCursors[index].mStamp != stamp) return 0;
+
+		return &mCursors[index];
+	}
+
+	/// Orders cursor indices by next index
+	struct ByNext {
+		const std::vector<Cursor> & mCursors;	///< Cursors being sorted
+
+		ByNext (const std::vector<Cursor> & cursors) : mCursors(cursors) {}
+
+		bool operator () (int i, int j) const { return mCursors[i].mNext < mCursors[j].mNext; }
+	};
+
+	/// Plans a removal, so that no running iterator skips or repeats an element
+	/// @param index Index of element being removed
+	/// @param moves [out] Pairs of (from, to) indices to apply, in order
+	/// @remark Each iterator has visited the elements before its next index. The vacancy is
+	/// walked upward across each of these boundaries that lies above it, by moving the last
+	/// element under the boundary into the vacancy and pulling the boundary down; the back
+	/// element then fills what remains.
+	void PlanRemoval (int index, std::vector<int> & moves)
+	{
+		mScratch.clear();
+
+		for (size_t i = 0; i < mCursors.size(); ++i)
+		{
+			if (mCursors[i].mStamp != 0 && mCursors[i].mNext > index) mScratch.push_back(int(i));
+		}
+
+		std::sort(mScratch.begin(), mScratch.end(), ByNext(mCursors));
+
+		int hole = index;
+
+		for (size_t i = 0; i < mScratch.size(); ++i)
+		{
+			int & next = mCursors[mScratch[i]].mNext;
+
+			if (next - 1 != hole)
+			{
+				moves.push_back(next - 1);
+				moves.push_back(hole);
+			}
+
+			hole = --next;
+		}
+
+		if (hole != mCount)
+		{
+			moves.push_back(mCount);
+			moves.push_back(hole);
+		}
+
+		--mCount;
+	}
+};
+
+namespace Lua
+{
+	/// OrderlessArray type name
+	template<> const char * luaT_type<OrderlessArray> (void) { return "OrderlessArray"; }
+}
+
+/// Dummy variables; the element and extra tables are stored in the environment under their addresses
+static int _elements;
+static int _extras;
+
+/// @return Array at index 1
+/// @remark Element and extra tables left on stack
+static OrderlessArray & Array (lua_State * L)
+{
+	OrderlessArray & A = luaT_ref<OrderlessArray>(L, 1);
+
+	lua_getfenv(L, 1);	// A, ..., env
+	lua_pushlightuserdata(L, &_elements);	// A, ..., env, ekey
+	lua_rawget(L, -2);	// A, ..., env, elements
+	lua_pushlightuserdata(L, &_extras);	// A, ..., env, elements, xkey
+	lua_rawget(L, -3);	// A, ..., env, elements, extras
+	lua_remove(L, -3);	// A, ..., elements, extras
+
+	return A;
+}
+
+/// Guards against changes during a batch removal
+static void CheckNotBusy (lua_State * L, OrderlessArray & A)
+{
+	if (A.mBusy) luaL_error(L, "Array is being batch-edited");
+}
+
+/// @remark Arguments: element
+static int Add (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	OrderlessArray & A = Array(L);	// A, element, elements, extras
+
+	CheckNotBusy(L, A);
+
+	lua_pushvalue(L, 2);// A, element, elements, extras, element
+	lua_rawseti(L, 3, ++A.mCount);	// A, element, elements = { ..., element }, extras
+
+	return 0;
+}
+
+/// @remark Arguments: index
+/// @return Indexed element
+static int Get (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	OrderlessArray & A = Array(L);	// A, index, elements, extras
+
+	int index = lua_isnumber(L, 2) ? sI(L, 2) : 0;
+
+	if (index >= 1 && index <= A.mCount) lua_rawgeti(L, 3, index);	// A, index, elements, extras, element
+
+	else lua_pushnil(L);// A, index, elements, extras, nil
+
+	return 1;
+}
+
+/// Cursor held by a running iterator
+/// @remark Its finalizer frees the cursor, should the iterator be dropped mid-loop without
+/// calling the reclaim function
+/// @remark Environment: { array }
+struct CursorGuard {
+	int mCursor;///< Cursor index
+	unsigned mStamp;///< Iterator's stamp
+};
+
+/// Dummy variable; the guard metatable is stored in the registry under its address
+static int _guard;
+
+/// @return Cursor held by a guard, or @b 0 if it has already been freed
+static OrderlessArray::Cursor * GuardedCursor (OrderlessArray & A, int guard, lua_State * L)
+{
+	CursorGuard * G = (CursorGuard *)lua_touserdata(L, guard);
+
+	return A.Get(G->mCursor, G->mStamp);
+}
+
+/// Guard finalizer
+static int GuardGC (lua_State * L)
+{
+	lua_getfenv(L, 1);	// guard, env
+	lua_rawgeti(L, 2, 1);	// guard, env, A
+
+	OrderlessArray::Cursor * cursor = GuardedCursor(luaT_ref<OrderlessArray>(L, 3), 1, L);
+
+	if (cursor) cursor->mStamp = 0;
+
+	return 0;
+}
+
+/// Iterator body
+/// @remark Upvalues: guard
+/// @return Index, element
+static int IpairsBody (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	OrderlessArray & A = Array(L);	// A, elements, extras
+
+	CheckNotBusy(L, A);
+
+	OrderlessArray::Cursor * cursor = GuardedCursor(A, lua_upvalueindex(1), L);
+
+	if (0 == cursor) return luaL_error(L, "Iterator is done");
+
+	if (cursor->mNext > A.mCount)
+	{
+		cursor->mStamp = 0;
+
+		return 0;
+	}
+
+	int index = cursor->mNext++;
+
+	lua_pushinteger(L, index);	// A, elements, extras, index
+	lua_rawgeti(L, 2, index);	// A, elements, extras, index, element
+
+	return 2;
+}
+
+/// Iterator reclaimer, for code that breaks or returns mid-iteration
+/// @remark Upvalues: guard
+/// @remark Arguments: A
+static int IpairsReclaim (lua_State * L)
+{
+	OrderlessArray::Cursor * cursor = GuardedCursor(luaT_ref<OrderlessArray>(L, 1), lua_upvalueindex(1), L);
+
+	if (cursor) cursor->mStamp = 0;
+
+	return 0;
+}
+
+/// Iterates over the array
+/// @return Iterator which supplies index, element; array; 0; reclaim function, which takes
+/// the array as argument and should be called if the loop is left early
+/// @remark Elements may be removed mid-iteration, by any means: each element still in the
+/// array is visited exactly once
+/// @remark If a loop is left early without reclaiming, the cursor is freed once the iterator
+/// is collected
+/// @see iterators.InstancedAutocacher
+static int Ipairs (lua_State * L)
+{
+	OrderlessArray & A = luaT_ref<OrderlessArray>(L, 1);
+
+	CheckNotBusy(L, A);
+
+	lua_settop(L, 1);	// A
+
+	// Make a guard for the cursor, tied to the array.
+	CursorGuard * G = (CursorGuard *)lua_newuserdata(L, sizeof(CursorGuard));	// A, guard
+
+	G->mCursor = A.Acquire(G->mStamp);
+
+	lua_pushlightuserdata(L, &_guard);	// A, guard, key
+	lua_rawget(L, LUA_REGISTRYINDEX);	// A, guard, meta?
+
+	if (lua_isnil(L, -1))
+	{
+		lua_pop(L, 1);	// A, guard
+		lua_createtable(L, 0, 1);	// A, guard, meta
+		lua_pushcfunction(L, GuardGC);	// A, guard, meta, GuardGC
+		lua_setfield(L, -2, "__gc");// A, guard, meta = { __gc = GuardGC }
+		lua_pushlightuserdata(L, &_guard);	// A, guard, meta, key
+		lua_pushvalue(L, -2);	// A, guard, meta, key, meta
+		lua_rawset(L, LUA_REGISTRYINDEX);	// A, guard, meta
+	}
+
+	lua_setmetatable(L, 2);	// A, guard
+	lua_createtable(L, 1, 0);	// A, guard, env
+	lua_pushvalue(L, 1);// A, guard, env, A
+	lua_rawseti(L, -2, 1);	// A, guard, env = { A }
+	lua_setfenv(L, 2);	// A, guard
+
+	// Supply the iterator and reclaimer, both bound to the guard.
+	lua_pushvalue(L, 2);// A, guard, guard
+	lua_pushcclosure(L, IpairsBody, 1);	// A, guard, body
+	lua_pushvalue(L, 1);// A, guard, body, A
+	lua_pushinteger(L, 0);	// A, guard, body, A, 0
+	lua_pushvalue(L, 2);// A, guard, body, A, 0, guard
+	lua_pushcclosure(L, IpairsReclaim, 1);	// A, guard, body, A, 0, reclaim
+
+	return 4;
+}
+
+/// Metamethod
+/// @return Array length
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, luaT_ref<OrderlessArray>(L, 1).mCount);	// A, count
+
+	return 1;
+}
+
+/// Removes and returns an extra element, if any
+/// @return Element
+static int PopExtra (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	OrderlessArray & A = Array(L);	// A, elements, extras
+
+	if (0 == A.mExtraCount) return 0;
+
+	lua_rawgeti(L, 3, A.mExtraCount);	// A, elements, extras, element
+	lua_pushnil(L);	// A, elements, extras, element, nil
+	lua_rawseti(L, 3, A.mExtraCount--);	// A, elements, extras = { ..., nil }, element
+
+	return 1;
+}
+
+/// Drops a removed element into the extras, unless cleared
+/// @param element Stack index of element
+/// @param extras Stack index of extras table
+static void AddExtra (lua_State * L, OrderlessArray & A, int element, int extras, bool bClear)
+{
+	if (!bClear && !lua_isnil(L, element))
+	{
+		lua_pushvalue(L, element);	// ..., element
+		lua_rawseti(L, extras, ++A.mExtraCount);// ...
+	}
+}
+
+/// Removes an element from the array
+/// @remark Arguments: index[, clear]
+/// @remark If @e clear is true, the element is not dropped into the extras
+static int Remove (lua_State * L)
+{
+	lua_settop(L, 3);
+
+	OrderlessArray & A = Array(L);	// A, index, clear, elements, extras
+
+	CheckNotBusy(L, A);
+
+	int index = lua_isnumber(L, 2) ? sI(L, 2) : 0;
+
+	if (index < 1 || index > A.mCount) return 0;
+
+	lua_rawgeti(L, 4, index);	// A, index, clear, elements, extras, element
+
+	AddExtra(L, A, 6, 5, lua_toboolean(L, 3) != 0);
+
+	// Fill the vacancy, keeping any running iterators consistent.
+	std::vector<int> & moves = A.mMoves;
+
+	moves.clear();
+
+	A.PlanRemoval(index, moves);
+
+	for (size_t i = 0; i < moves.size(); i += 2)
+	{
+		lua_rawgeti(L, 4, moves[i]);// A, index, clear, elements, extras, element, moved
+		lua_rawseti(L, 4, moves[i + 1]);// A, index, clear, elements = { ..., [to] = moved }, extras, element
+	}
+
+	lua_pushnil(L);	// A, index, clear, elements, extras, element, nil
+	lua_rawseti(L, 4, A.mCount + 1);// A, index, clear, elements = { ..., nil }, extras, element
+
+	return 0;
+}
+
+/// Removes every element that satisfies a predicate, in one pass
+/// @remark Arguments: pred[, clear]
+/// @remark @e pred is called as pred(element, index); the elements that remain keep their
+/// relative order, and running iterators resume at the first unvisited one
+/// @remark If @e clear is true, removed elements are not dropped into the extras
+/// @return Count of removed elements
+static int RemoveIf (lua_State * L)
+{
+	lua_settop(L, 3);
+
+	OrderlessArray & A = Array(L);	// A, pred, clear, elements, extras
+
+	CheckNotBusy(L, A);
+
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+
+	bool bClear = lua_toboolean(L, 3) != 0;
+	int n = A.mCount, kept = 0, read = 1, result = 0;
+
+	A.mBusy = true;
+
+	for (; read <= n && 0 == result; ++read)
+	{
+		// Iterators resume at the first survivor from their next index onward.
+		for (size_t i = 0; i < A.mCursors.size(); ++i)
+		{
+			if (A.mCursors[i].mStamp != 0 && A.mCursors[i].mNext == read) A.mCursors[i].mNext = -(kept + 1);
+		}
+
+		lua_pushvalue(L, 2);// A, pred, clear, elements, extras, pred
+		lua_rawgeti(L, 4, read);// A, pred, clear, elements, extras, pred, element
+		lua_pushinteger(L, read);	// A, pred, clear, elements, extras, pred, element, index
+
+		result = lua_pcall(L, 2, 1, 0);	// A, pred, clear, elements, extras, remove / err
+
+		if (0 == result)
+		{
+			bool bRemove = lua_toboolean(L, 6) != 0;
+
+			lua_pop(L, 1);	// A, pred, clear, elements, extras
+			lua_rawgeti(L, 4, read);// A, pred, clear, elements, extras, element
+
+			if (bRemove) AddExtra(L, A, 6, 5, bClear);
+
+			else if (++kept != read) lua_rawseti(L, 4, kept);	// A, pred, clear, elements = { ..., [kept] = element }, extras
+
+			lua_settop(L, 5);	// A, pred, clear, elements, extras
+		}
+	}
+
+	// On error, keep whatever was not yet visited.
+	if (result != 0) --read;
+
+	for (; read <= n; ++read)
+	{
+		for (size_t i = 0; i < A.mCursors.size(); ++i)
+		{
+			if (A.mCursors[i].mStamp != 0 && A.mCursors[i].mNext == read) A.mCursors[i].mNext = -(kept + 1);
+		}
+
+		if (++kept == read) continue;
+
+		lua_rawgeti(L, 4, read);// A, pred, clear, elements, extras[, err], element
+		lua_rawseti(L, 4, kept);// A, pred, clear, elements = { ..., [kept] = element }, extras[, err]
+	}
+
+	for (int i = kept + 1; i <= n; ++i)
+	{
+		lua_pushnil(L);	// A, pred, clear, elements, extras[, err], nil
+		lua_rawseti(L, 4, i);	// A, pred, clear, elements = { ..., nil }, extras[, err]
+	}
+
+	for (size_t i = 0; i < A.mCursors.size(); ++i)
+	{
+		int & next = A.mCursors[i].mNext;
+
+		if (A.mCursors[i].mStamp != 0) next = next < 0 ? -next : kept + 1;
+	}
+
+	A.mCount = kept;
+	A.mBusy = false;
+
+	if (result != 0) return lua_error(L);
+
+	lua_pushinteger(L, n - kept);	// A, pred, clear, elements, extras, count
+
+	return 1;
+}
+
+/// Metamethod
+/// @remark The array is left empty rather than destroyed outright, since the finalizers of
+/// its iterators' guards may still free their cursors afterward
+static int GC (lua_State * L)
+{
+	OrderlessArray & A = luaT_ref<OrderlessArray>(L, 1);
+
+	A.~OrderlessArray();
+
+	new (&A) OrderlessArray;
+
+	return 0;
+}
+
+/// Constructor
+static int Cons (lua_State * L)
+{
+	new (UD(L, 1)) OrderlessArray;
+
+	lua_getfenv(L, 1);	// A, ..., env
+	lua_pushlightuserdata(L, &_elements);	// A, ..., env, ekey
+	lua_newtable(L);// A, ..., env, ekey, {}
+	lua_rawset(L, -3);	// A, ..., env = { [ekey] = {} }
+	lua_pushlightuserdata(L, &_extras);	// A, ..., env, xkey
+	lua_newtable(L);// A, ..., env, xkey, {}
+	lua_rawset(L, -3);	// A, ..., env = { ..., [xkey] = {} }
+
+	return 0;
+}
+
+/// Binds the OrderlessArray class
+/// @remark This must be done before the scripts are loaded, in which case it supersedes
+/// the script version
+int Bindings::open_orderlessarray (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Add", Add },
+		{ "Get", Get },
+		{ "Ipairs", Ipairs },
+		{ "PopExtra", PopExtra },
+		{ "Remove", Remove },
+		{ "RemoveIf", RemoveIf },
+		{ "__cons", Cons },
+		{ "__gc", GC },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "OrderlessArray", methods, Class::Def(sizeof(OrderlessArray)));
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <vector>
+
+using namespace Lua;
+
+/// Array-based d-ary min-heap over numeric priorities, with removal and re-prioritization by handle
+/// @remark Values live in a table in the queue's environment, indexed by slot
+struct PriorityQueue {
+	enum {
+		eArity = 4,	///< Children per node
+		eMaxSlots = 1 << 24,///< Slot limit, so that a slot fits below a handle's generation
+		eGenerationMask = (1 << 28) - 1	///< Generations wrap within this mask, keeping handles exact as lua_Numbers
+	};
+
+	/// Heap entry
+	struct Entry {
+		double mPriority;	///< Entry priority; lower comes first
+		int mSlot;	///< Slot of entry's value
+	};
+
+	std::vector<Entry> mHeap;	///< Heap array
+	std::vector<int> mPositions;///< Heap position of each slot, or -1 if free
+	std::vector<int> mGenerations;	///< Generation of each slot, bumped on release
+	std::vector<int> mFree;	///< Free slots
+
+	/// Swaps two heap entries, keeping positions in sync
+	void Swap (int i, int j)
+	{
+		Entry temp = mHeap[i];
+
+		mHeap[i] = mHeap[j];
+		mHeap[j] = temp;
+
+		mPositions[mHeap[i].mSlot] = i;
+		mPositions[mHeap[j].mSlot] = j;
+	}
+
+	/// Moves an entry toward the root until its parent comes first
+	void SiftUp (int i)
+	{
+		for (int parent; i > 0 && mHeap[i].mPriority < mHeap[parent = (i - 1) / eArity].mPriority; i = parent) Swap(i, parent);
+	}
+
+	/// Moves an entry toward the leaves until it comes before all its children
+	void SiftDown (int i)
+	{
+		for (int n = int(mHeap.size()); ; )
+		{
+			int first = i * eArity + 1, best = i;
+
+			for (int child = first; child < first + eArity && child < n; ++child)
+			{
+				if (mHeap[child].mPriority < mHeap[best].mPriority) best = child;
+			}
+
+			if (best == i) break;
+
+			Swap(i, best);
+
+			i = best;
+		}
+	}
+
+	/// Claims a free slot
+	/// @return Slot index
+	int Acquire (void)
+	{
+		if (!mFree.empty())
+		{
+			int slot = mFree.back();
+
+			mFree.pop_back();
+
+			return slot;
+		}
+
+		mPositions.push_back(-1);
+		mGenerations.push_back(0);
+
+		return int(mPositions.size()) - 1;
+	}
+
+	/// Puts a slot's entry into the heap
+	void Push (int slot, double priority)
+	{
+		Entry entry = { priority, slot };
+
+		mPositions[slot] = int(mHeap.size());
+
+		mHeap.push_back(entry);
+
+		SiftUp(int(mHeap.size()) - 1);
+	}
+
+	/// Takes an entry out of the heap and frees its slot
+	/// @param i Heap position
+	void Erase (int i)
+	{
+		int slot = mHeap[i].mSlot, last = int(mHeap.size()) - 1;
+
+		if (i != last)
+		{
+			Swap(i, last);
+
+			mHeap.pop_back();
+
+			SiftDown(i);
+			SiftUp(i);
+		}
+
+		else mHeap.pop_back();
+
+		Retire(slot);
+	}
+
+	/// Frees a slot, invalidating its handles
+	void Retire (int slot)
+	{
+		mPositions[slot] = -1;
+		mGenerations[slot] = (mGenerations[slot] + 1) & eGenerationMask;
+
+		mFree.push_back(slot);
+	}
+
+	/// @return If @b true, every slot is in use
+	bool IsFull (void) const
+	{
+		return mFree.empty() && int(mPositions.size()) >= eMaxSlots;
+	}
+
+	/// @return Handle for a slot, in its current generation
+	double HandleOf (int slot) const
+	{
+		return double(mGenerations[slot]) * 16777216.0 + slot;
+	}
+
+	/// @return Slot for a handle, or -1 if the handle is stale
+	int SlotOf (double handle) const
+	{
+		double gen = double(long(handle / 16777216.0));
+		int slot = int(handle - gen * 16777216.0);
+
+		if (slot < 0 || slot >= int(mPositions.size()) || mPositions[slot] < 0 || mGenerations[slot] != int(gen)) return -1;
+
+		return slot;
+	}
+};
+
+namespace Lua
+{
+	/// PriorityQueue type name
+	template<> const char * luaT_type<PriorityQueue> (void) { return "PriorityQueue"; }
+}
+
+/// Dummy variable; the value table is stored in the environment under its address
+static int _values;
+
+/// @return Queue at index 1
+/// @remark Value table left on stack
+static PriorityQueue & Queue (lua_State * L)
+{
+	PriorityQueue & Q = luaT_ref<PriorityQueue>(L, 1);
+
+	lua_getfenv(L, 1);	// Q, ..., env
+	lua_pushlightuserdata(L, &_values);	// Q, ..., env, key
+	lua_rawget(L, -2);	// Q, ..., env, values
+	lua_replace(L, -2);	// Q, ..., values
+
+	return Q;
+}
+
+/// Gets a slot's value, and optionally frees it
+/// @param values Stack index of value table
+/// @param slot Slot index
+/// @param bClear If @b true, clear the value
+static void GetValue (lua_State * L, int values, int slot, bool bClear)
+{
+	lua_rawgeti(L, values, slot + 1);	// ..., value
+
+	if (bClear)
+	{
+		lua_pushnil(L);	// ..., value, nil
+		lua_rawseti(L, values, slot + 1);	// ..., value
+	}
+}
+
+/// Empties the queue
+static int Clear (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	PriorityQueue & Q = Queue(L);	// Q, values
+
+	for (size_t i = 0; i < Q.mHeap.size(); ++i)
+	{
+		int slot = Q.mHeap[i].mSlot;
+
+		lua_pushnil(L);	// Q, values, nil
+		lua_rawseti(L, 2, slot + 1);// Q, values
+
+		Q.Retire(slot);
+	}
+
+	Q.mHeap.clear();
+
+	return 0;
+}
+
+/// Loads the queue in bulk, replacing its contents
+/// @remark Arguments: values, priorities[, handles_out]
+/// @return If @e handles_out was supplied, that table, filled with the new handles, in the
+/// same order as @e values
+/// @remark Builds the heap bottom-up, in linear time
+static int Heapify (lua_State * L)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+	luaL_checktype(L, 3, LUA_TTABLE);
+	lua_settop(L, 4);
+
+	// Read every priority before touching the queue, so that a bad one leaves it as it was.
+	int count = GetN(L, 2);
+
+	luaL_argcheck(L, count <= PriorityQueue::eMaxSlots, 2, "Too many values");
+
+	std::vector<double> priorities(count);
+
+	for (int i = 1; i <= count; ++i)
+	{
+		lua_rawgeti(L, 3, i);	// Q, V, P, out, priority
+
+		if (!lua_isnumber(L, -1)) luaL_error(L, "Priority #%d: number expected", i);
+
+		priorities[i - 1] = lua_tonumber(L, -1);
+
+		lua_pop(L, 1);	// Q, V, P, out
+	}
+
+	lua_pushcfunction(L, Clear);// Q, V, P, out, Clear
+	lua_pushvalue(L, 1);// Q, V, P, out, Clear, Q
+	lua_call(L, 1, 0);	// Q, V, P, out
+
+	PriorityQueue & Q = Queue(L);	// Q, V, P, out, values
+
+	std::vector<int> slots(count);
+
+	for (int i = 1; i <= count; ++i)
+	{
+		int slot = slots[i - 1] = Q.Acquire();
+
+		PriorityQueue::Entry entry = { priorities[i - 1], slot };
+
+		lua_rawgeti(L, 2, i);	// Q, V, P, out, values, value
+		lua_rawseti(L, 5, slot + 1);// Q, V, P, out, values = { ..., [slot] = value }
+
+		Q.mPositions[slot] = int(Q.mHeap.size());
+
+		Q.mHeap.push_back(entry);
+	}
+
+	for (int i = (count - 2) / PriorityQueue::eArity; i >= 0 && count > 1; --i) Q.SiftDown(i);
+
+	if (!lua_istable(L, 4)) return 0;
+
+	lua_pop(L, 1);	// Q, V, P, out
+
+	PrepOutTable(L, 4, count);	// Q, V, P, out, out
+
+	// Sifting reorders the heap, so report handles by input position instead.
+	for (int i = 0; i < count; ++i)
+	{
+		lua_pushnumber(L, Q.HandleOf(slots[i]));// Q, V, P, out, out, handle
+		lua_rawseti(L, -2, i + 1);	// Q, V, P, out, out = { ..., handle }
+	}
+
+	return 1;
+}
+
+/// Adds a value
+/// @remark Arguments: value, priority
+/// @return Handle, for use with RemoveHandle() and Update()
+static int Insert (lua_State * L)
+{
+	lua_settop(L, 3);
+
+	double priority = D(L, 3);
+
+	PriorityQueue & Q = Queue(L);	// Q, value, priority, values
+
+	if (Q.IsFull()) return luaL_error(L, "Queue is full");
+
+	int slot = Q.Acquire();
+
+	lua_pushvalue(L, 2);// Q, value, priority, values, value
+	lua_rawseti(L, 4, slot + 1);// Q, value, priority, values = { ..., [slot] = value }
+
+	Q.Push(slot, priority);
+
+	lua_pushnumber(L, Q.HandleOf(slot));// Q, value, priority, values, handle
+
+	return 1;
+}
+
+/// @return If @b true, the queue is empty
+static int IsEmpty (lua_State * L)
+{
+	lua_pushboolean(L, luaT_ref<PriorityQueue>(L, 1).mHeap.empty());	// Q, bEmpty
+
+	return 1;
+}
+
+/// Removes the value with lowest priority
+/// @return Removed value and its priority
+static int Remove (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	PriorityQueue & Q = Queue(L);	// Q, values
+
+	if (Q.mHeap.empty()) luaL_error(L, "Remove called on empty queue");
+
+	PriorityQueue::Entry root = Q.mHeap[0];
+
+	GetValue(L, 2, root.mSlot, true);	// Q, values, value
+
+	Q.Erase(0);
+
+	lua_pushnumber(L, root.mPriority);	// Q, values, value, priority
+
+	return 2;
+}
+
+/// Removes a value by handle
+/// @remark Arguments: handle
+/// @return Removed value and its priority, or nothing if the handle is stale
+static int RemoveHandle (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	double handle = D(L, 2);
+
+	PriorityQueue & Q = Queue(L);	// Q, handle, values
+
+	int slot = Q.SlotOf(handle);
+
+	if (slot < 0) return 0;
+
+	double priority = Q.mHeap[Q.mPositions[slot]].mPriority;
+
+	GetValue(L, 3, slot, true);	// Q, handle, values, value
+
+	Q.Erase(Q.mPositions[slot]);
+
+	lua_pushnumber(L, priority);// Q, handle, values, value, priority
+
+	return 2;
+}
+
+/// Peeks at the value with lowest priority
+/// @return Value and its priority, or nothing if the queue is empty
+static int Root (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	PriorityQueue & Q = Queue(L);	// Q, values
+
+	if (Q.mHeap.empty()) return 0;
+
+	GetValue(L, 2, Q.mHeap[0].mSlot, false);// Q, values, value
+
+	lua_pushnumber(L, Q.mHeap[0].mPriority);// Q, values, value, priority
+
+	return 2;
+}
+
+/// Changes a value's priority, in either direction
+/// @remark Arguments: handle, priority
+/// @return If @b true, the handle was valid
+static int Update (lua_State * L)
+{
+	PriorityQueue & Q = luaT_ref<PriorityQueue>(L, 1);
+
+	int slot = Q.SlotOf(D(L, 2));
+
+	if (slot >= 0)
+	{
+		int i = Q.mPositions[slot];
+
+		Q.mHeap[i].mPriority = D(L, 3);
+
+		Q.SiftDown(i);
+		Q.SiftUp(Q.mPositions[slot]);
+	}
+
+	lua_pushboolean(L, slot >= 0);	// Q, handle, priority, bValid
+
+	return 1;
+}
+
+/// Metamethod
+/// @return Count of values in queue
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(luaT_ref<PriorityQueue>(L, 1).mHeap.size()));	// Q, count
+
+	return 1;
+}
+
+/// Constructor
+static int Cons (lua_State * L)
+{
+	new (UD(L, 1)) PriorityQueue;
+
+	lua_getfenv(L, 1);	// Q, ..., env
+	lua_pushlightuserdata(L, &_values);	// Q, ..., env, key
+	lua_newtable(L);// Q, ..., env, key, {}
+	lua_rawset(L, -3);	// Q, ..., env = { [key] = {} }
+
+	return 0;
+}
+
+/// Binds the PriorityQueue class
+int Bindings::open_priorityqueue (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Clear", Clear },
+		{ "Heapify", Heapify },
+		{ "Insert", Insert },
+		{ "IsEmpty", IsEmpty },
+		{ "Remove", Remove },
+		{ "RemoveHandle", RemoveHandle },
+		{ "Root", Root },
+		{ "Update", Update },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<PriorityQueue> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "PriorityQueue", methods, Class::Def(sizeof(PriorityQueue)));
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+
+using namespace Lua;
+
+/// Signal / slot dispatch for Signalable objects
+/// @remark Signal names are interned once, globally, to dense integer IDs. Each object
+/// then has a slot array indexed by ID, found through one weak-keyed lookup on the object,
+/// rather than a slot table per signal, each weak-keyed on the objects.
+/// @remark The environment holds the interned names, in both directions, and the slot
+/// arrays
+enum { eNames = 1, eIDs, eSlots };
+
+/// @return ID of a signal name, interned if requested; 0 if the name was never interned
+static int GetID (lua_State * L, int index, bool bIntern)
+{
+	luaL_argcheck(L, !lua_isnoneornil(L, index), index, "Invalid signal");
+
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eNames);	// ..., names
+	lua_pushvalue(L, index);// ..., names, name
+	lua_rawget(L, -2);	// ..., names, id?
+
+	int id = lua_tointeger(L, -1);
+
+	if (0 == id && bIntern)
+	{
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// ..., names, nil, ids
+
+		id = int(lua_objlen(L, -1)) + 1;
+
+		lua_pushvalue(L, index);// ..., names, nil, ids, name
+		lua_rawseti(L, -2, id);	// ..., names, nil, ids = { ..., name }
+		lua_pushvalue(L, index);// ..., names, nil, ids, name
+		lua_pushinteger(L, id);	// ..., names, nil, ids, name, id
+		lua_rawset(L, -5);	// ..., names = { ..., name = id }, nil, ids
+		lua_pop(L, 1);	// ..., names, nil
+	}
+
+	lua_pop(L, 2);	// ...
+
+	return id;
+}
+
+/// Pushes an object's slot for a signal, if it has one
+/// @param object Stack index of object
+/// @return If true, the slot was pushed
+static bool PushSlot (lua_State * L, int object, int id)
+{
+	if (0 == id) return false;
+
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eSlots);	// ..., slots
+	lua_pushvalue(L, object);	// ..., slots, object
+	lua_rawget(L, -2);	// ..., slots, array?
+
+	if (lua_istable(L, -1))
+	{
+		lua_rawgeti(L, -1, id);	// ..., slots, array, slot?
+
+		if (!lua_isnil(L, -1))
+		{
+			lua_replace(L, -3);	// ..., slot, array
+			lua_pop(L, 1);	// ..., slot
+
+			return true;
+		}
+
+		lua_pop(L, 1);	// ..., slots, array
+	}
+
+	lua_pop(L, 2);	// ...
+
+	return false;
+}
+
+/// @remark Arguments: object, signal
+/// @return Slot, or nil if absent
+static int GetSlot (lua_State * L)
+{
+	if (!PushSlot(L, 1, GetID(L, 2, false))) lua_pushnil(L);// object, signal, slot / nil
+
+	return 1;
+}
+
+/// Assigns or clears an object's slot for a signal
+/// @remark Arguments: object, signal, slot
+static int SetSlot (lua_State * L)
+{
+	luaL_argcheck(L, !lua_isnoneornil(L, 1), 1, "Invalid object");
+
+	int id = GetID(L, 2, !lua_isnil(L, 3));
+
+	if (0 == id) return 0;
+
+	lua_settop(L, 3);	// object, signal, slot
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eSlots);	// object, signal, slot, slots
+	lua_pushvalue(L, 1);// object, signal, slot, slots, object
+	lua_rawget(L, -2);	// object, signal, slot, slots, array?
+
+	if (!lua_istable(L, -1))
+	{
+		if (lua_isnil(L, 3)) return 0;
+
+		lua_pop(L, 1);	// object, signal, slot, slots
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// object, signal, slot, slots, ids
+		lua_createtable(L, int(lua_objlen(L, -1)), 0);	// object, signal, slot, slots, ids, array
+		lua_replace(L, -2);	// object, signal, slot, slots, array
+		lua_pushvalue(L, 1);// object, signal, slot, slots, array, object
+		lua_pushvalue(L, -2);	// object, signal, slot, slots, array, object, array
+		lua_rawset(L, -4);	// object, signal, slot, slots = { ..., object = array }, array
+	}
+
+	lua_pushvalue(L, 3);// object, signal, slot, slots, array, slot
+	lua_rawseti(L, -2, id);	// object, signal, slot, slots, array = { ..., slot }
+
+	return 0;
+}
+
+/// Sends a signal to an object, calling its slot, if it has one, as slot(object, ...)
+/// @remark Arguments: object, signal, ...
+/// @return Call results, if the slot existed; otherwise, nothing
+static int Signal (lua_State * L)
+{
+	if (!PushSlot(L, 1, GetID(L, 2, false))) return 0;
+
+	lua_pushvalue(L, 1);// object, signal, ..., slot, object
+	lua_replace(L, 2);	// object, object, ..., slot
+	lua_replace(L, 1);	// slot, object, ...
+	lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);// ...
+
+	return lua_gettop(L);
+}
+
+/// Sends a signal to each object in an array, in order, as per Signal
+/// @remark Arguments: objects, signal, ...
+/// @remark Objects are visited up to the first nil; any results are discarded
+static int SignalMany (lua_State * L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	int id = GetID(L, 2, false), top = lua_gettop(L);
+
+	if (0 == id) return 0;
+
+	luaL_checkstack(L, top + 2, "Too many arguments");
+
+	for (int i = 1; ; ++i)
+	{
+		lua_rawgeti(L, 1, i);	// objects, signal, ..., object?
+
+		if (lua_isnil(L, -1)) break;
+
+		if (PushSlot(L, top + 1, id))	// objects, signal, ..., object[, slot]
+		{
+			lua_insert(L, -2);	// objects, signal, ..., slot, object
+
+			for (int arg = 3; arg <= top; ++arg) lua_pushvalue(L, arg);	// objects, signal, ..., slot, object, ...
+
+			lua_call(L, top - 1, 0);// objects, signal, ...
+		}
+
+		else lua_pop(L, 1);	// objects, signal, ...
+	}
+
+	return 0;
+}
+
+/// Registers the signal_dispatch library
+int Bindings::open_signaldispatch (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "GetSlot", GetSlot },
+		{ "SetSlot", SetSlot },
+		{ "Signal", Signal },
+		{ "SignalMany", SignalMany },
+		{ 0, 0 }
+	};
+
+	// Build the environment: the interned names, in both directions, and the slot arrays,
+	// weak-keyed on the objects.
+	lua_createtable(L, 3, 0);	// env
+	lua_newtable(L);// env, names
+	lua_rawseti(L, -2, eNames);	// env = { names }
+	lua_newtable(L);// env, ids
+	lua_rawseti(L, -2, eIDs);	// env = { names, ids }
+	lua_newtable(L);// env, slots
+	lua_createtable(L, 0, 1);	// env, slots, mt
+	lua_pushliteral(L, "k");// env, slots, mt, "k"
+	lua_setfield(L, -2, "__mode");	// env, slots, mt = { __mode = "k" }
+	lua_setmetatable(L, -2);// env, slots
+	lua_rawseti(L, -2, eSlots);	// env = { names, ids, slots }
+
+	Register(L, "signal_dispatch", funcs, -1);
+
+	lua_pop(L, 1);
+
+	return 0;
+}
@@ -0,0 +1,444 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include "Lua_/Vec3Array.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Lua;
+
+/// Uniform hash grid over points, keyed by positive integer IDs
+/// @remark IDs index straight into the item array, so they should be dense, e.g. the
+/// positions of entities in a script-side list
+struct SpatialGrid {
+	enum { eMaxBuckets = 1 << 24 };	///< Largest bucket count
+
+	/// Grid entry
+	struct Item {
+		float mP[3];///< Position
+		int mCell[3];	///< Cell coordinates
+		int mBucket;///< Bucket index, or -1 if not in grid
+		int mPrev;	///< Previous item in bucket, or -1
+		int mNext;	///< Next item in bucket, or -1
+	};
+
+	/// Query result
+	struct Hit {
+		float mDist2;	///< Squared distance to query point
+		int mID;///< Item ID
+
+		bool operator < (const Hit & other) const { return mDist2 < other.mDist2; }
+	};
+
+	std::vector<Item> mItems;	///< Items, indexed by ID - 1
+	std::vector<int> mBuckets;	///< Bucket list heads, or -1 if empty
+	float mCellSize;///< Cell edge length
+	int mLive;	///< Count of items in grid
+
+	SpatialGrid (float cellSize, int buckets) : mBuckets(buckets, -1), mCellSize(cellSize), mLive(0) {}
+
+	/// @return Cell coordinate of a position component
+	/// @remark Coordinates are clamped well inside the int range, so that huge or infinite
+	/// positions (e.g. a point minus an unbounded search radius) still convert safely; NaNs
+	/// land on the low end
+	int CellOf (float x) const
+	{
+		const double Limit = double(1 << 30);
+
+		double cell = std::floor(double(x) / mCellSize);
+
+		if (!(cell > -Limit)) return -(1 << 30);
+		if (cell > Limit) return 1 << 30;
+
+		return int(cell);
+	}
+
+	/// @return Bucket index of a cell
+	int BucketOf (const int cell[3]) const
+	{
+		unsigned int h = unsigned(cell[0]) * 73856093U ^ unsigned(cell[1]) * 19349663U ^ unsigned(cell[2]) * 83492791U;
+
+		return int(h & unsigned(mBuckets.size() - 1));
+	}
+
+	void Clear (void);
+	void Link (int index);
+	void Remove (int id);
+	void Set (int id, const float p[3]);
+	bool Gather (const float p[3], float radius, float minRadius, std::vector<Hit> & hits) const;
+};
+
+namespace Lua
+{
+	/// SpatialGrid type name
+	template<> const char * luaT_type<SpatialGrid> (void) { return "SpatialGrid"; }
+}
+
+/// Removes all items
+void SpatialGrid::Clear (void)
+{
+	mItems.clear();
+
+	std::fill(mBuckets.begin(), mBuckets.end(), -1);
+
+	mLive = 0;
+}
+
+/// Puts an item at the head of its cell's bucket
+/// @param index Item index
+void SpatialGrid::Link (int index)
+{
+	Item & item = mItems[index];
+
+	item.mBucket = BucketOf(item.mCell);
+	item.mPrev = -1;
+	item.mNext = mBuckets[item.mBucket];
+
+	if (item.mNext != -1) mItems[item.mNext].mPrev = index;
+
+	mBuckets[item.mBucket] = index;
+}
+
+/// Removes an item, if present
+/// @param id Item ID
+void SpatialGrid::Remove (int id)
+{
+	if (id < 1 || id > int(mItems.size()) || -1 == mItems[id - 1].mBucket) return;
+
+	Item & item = mItems[id - 1];
+
+	if (item.mPrev != -1) mItems[item.mPrev].mNext = item.mNext;
+
+	else mBuckets[item.mBucket] = item.mNext;
+
+	if (item.mNext != -1) mItems[item.mNext].mPrev = item.mPrev;
+
+	item.mBucket = -1;
+
+	--mLive;
+}
+
+/// Adds or moves an item
+/// @param id Item ID
+/// @param p Item position
+/// @remark An item that stays in its cell is only repositioned
+void SpatialGrid::Set (int id, const float p[3])
+{
+	if (id > int(mItems.size()))
+	{
+		Item item;
+
+		item.mBucket = -1;
+
+		mItems.resize(id, item);
+	}
+
+	Item & item = mItems[id - 1];
+	int cell[3] = { CellOf(p[0]), CellOf(p[1]), CellOf(p[2]) };
+
+	std::copy(p, p + 3, item.mP);
+
+	if (item.mBucket != -1 && std::equal(cell, cell + 3, item.mCell)) return;
+
+	Remove(id);
+
+	std::copy(cell, cell + 3, item.mCell);
+
+	Link(id - 1);
+
+	++mLive;
+}
+
+/// Gathers items strictly between two distances from a point
+/// @param p Query point
+/// @param radius Outer radius
+/// @param minRadius Inner radius
+/// @param hits [out] Items found (appended)
+/// @return If @b true, every item in the grid was examined
+bool SpatialGrid::Gather (const float p[3], float radius, float minRadius, std::vector<Hit> & hits) const
+{
+	float r2 = radius * radius, min2 = minRadius < 0.0f ? -1.0f : minRadius * minRadius;
+	int lo[3], hi[3];
+	double cells = 1.0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		lo[i] = CellOf(p[i] - radius);
+		hi[i] = CellOf(p[i] + radius);
+
+		cells *= double(hi[i]) - double(lo[i]) + 1.0;
+	}
+
+	// Past a certain point, walking cells costs more than checking every item.
+	if (cells > double(mLive))
+	{
+		for (int index = 0; index < int(mItems.size()); ++index)
+		{
+			const Item & item = mItems[index];
+
+			if (-1 == item.mBucket) continue;
+
+			float dx = item.mP[0] - p[0], dy = item.mP[1] - p[1], dz = item.mP[2] - p[2];
+			Hit hit = { dx * dx + dy * dy + dz * dz, index + 1 };
+
+			if (hit.mDist2 < r2 && hit.mDist2 > min2) hits.push_back(hit);
+		}
+
+		return true;
+	}
+
+	// Otherwise, walk the cells overlapping the query. Buckets are shared by any cells that
+	// hash alike, so only items in the cell being visited are considered.
+	int cell[3];
+
+	for (cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0])
+	{
+		for (cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1])
+		{
+			for (cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2])
+			{
+				for (int index = mBuckets[BucketOf(cell)]; index != -1; index = mItems[index].mNext)
+				{
+					const Item & item = mItems[index];
+
+					if (!std::equal(cell, cell + 3, item.mCell)) continue;
+
+					float dx = item.mP[0] - p[0], dy = item.mP[1] - p[1], dz = item.mP[2] - p[2];
+					Hit hit = { dx * dx + dy * dy + dz * dz, index + 1 };
+
+					if (hit.mDist2 < r2 && hit.mDist2 > min2) hits.push_back(hit);
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+/// Writes the IDs of a series of hits into a results table
+/// @param hits Hits to write
+/// @param count Count of hits to write
+/// @param out Stack index of optional results table
+/// @return 2 (results table and count)
+static int PushHits (lua_State * L, const std::vector<SpatialGrid::Hit> & hits, size_t count, int out)
+{
+	PrepOutTable(L, out, int(count));	// ..., out
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		lua_pushinteger(L, hits[i].mID);// ..., out, id
+		lua_rawseti(L, -2, int(i + 1));	// ..., out = { ..., id }
+	}
+
+	lua_pushinteger(L, lua_Integer(count));	// ..., out, count
+
+	return 2;
+}
+
+/// @return Grid at index 1
+static SpatialGrid & Grid (lua_State * L)
+{
+	return luaT_ref<SpatialGrid>(L, 1);
+}
+
+/// Removes all items
+static int Clear (lua_State * L)
+{
+	Grid(L).Clear();
+
+	return 0;
+}
+
+/// Finds items whose direction from a point lies within a cone
+/// @return Table of IDs, and their count
+/// @remark Arguments: point, direction, radius, cos_min[, out]
+/// @remark Items are kept when the cosine of the angle between @e direction and the
+/// offset to the item exceeds @e cos_min; a @e cos_min of 0 gives a half-space test, as
+/// per script_helpers.IsInFront
+static int InCone (lua_State * L)
+{
+	SpatialGrid & grid = Grid(L);
+
+	float p[3], d[3];
+
+	int arg = Types::Point_(L, Types::Point_(L, 2, p), d);
+	float radius = F(L, arg), cosMin = F(L, arg + 1);
+
+	std::vector<SpatialGrid::Hit> hits;
+
+	grid.Gather(p, radius, -1.0f, hits);
+
+	// Keep the hits inside the cone. Comparing squares avoids square roots; the sign of
+	// the dot product is checked separately, since squaring loses it.
+	float dlen2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+	size_t kept = 0;
+
+	for (size_t i = 0; i < hits.size(); ++i)
+	{
+		const SpatialGrid::Item & item = grid.mItems[hits[i].mID - 1];
+
+		float dot = (item.mP[0] - p[0]) * d[0] + (item.mP[1] - p[1]) * d[1] + (item.mP[2] - p[2]) * d[2];
+		float bound = cosMin * cosMin * hits[i].mDist2 * dlen2;
+
+		if (cosMin >= 0.0f ? dot > 0.0f && dot * dot > bound : dot > 0.0f || dot * dot < bound) hits[kept++] = hits[i];
+	}
+
+	return PushHits(L, hits, kept, arg + 2);
+}
+
+/// Finds the items nearest a point, in order of increasing distance
+/// @return Table of IDs, and their count (at most @e k)
+/// @remark Arguments: point, k[, max_radius[, out]]
+static int Nearest (lua_State * L)
+{
+	SpatialGrid & grid = Grid(L);
+
+	float p[3];
+
+	int arg = Types::Point_(L, 2, p);
+	size_t k = uI(L, arg);
+	float maxRadius = float(luaL_optnumber(L, arg + 1, HUGE_VAL));
+
+	// Grow the search radius until enough items turn up. Any item outside the radius is
+	// farther than those within, so the first k of a large enough set are the nearest.
+	std::vector<SpatialGrid::Hit> hits;
+
+	for (float radius = grid.mCellSize; ; radius *= 2.0f)
+	{
+		hits.clear();
+
+		if (radius > maxRadius) radius = maxRadius;
+
+		bool bAll = grid.Gather(p, radius, -1.0f, hits);
+
+		if (bAll || hits.size() >= k || radius >= maxRadius) break;
+	}
+
+	if (hits.size() < k) k = hits.size();
+
+	std::partial_sort(hits.begin(), hits.begin() + k, hits.end());
+
+	return PushHits(L, hits, k, arg + 2);
+}
+
+/// Removes an item
+/// @remark Arguments: id
+static int Remove (lua_State * L)
+{
+	Grid(L).Remove(sI(L, 2));
+
+	return 0;
+}
+
+/// Rebuilds the grid from an array of positions; item IDs are the array indices
+/// @remark Arguments: Vec3Array
+static int Rebuild (lua_State * L)
+{
+	SpatialGrid & grid = Grid(L);
+	Vec3Array & arr = Types::Vec3Array_r(L, 2);
+
+	grid.Clear();
+
+	for (size_t i = 0; i < arr.mCount; ++i)
+	{
+		float p[3] = { arr.mX[i], arr.mY[i], arr.mZ[i] };
+
+		grid.Set(int(i + 1), p);
+	}
+
+	return 0;
+}
+
+/// Adds an item, or moves it if already present
+/// @remark Arguments: id, point
+static int Set (lua_State * L)
+{
+	int id = sI(L, 2);
+
+	luaL_argcheck(L, id > 0, 2, "Non-positive ID");
+
+	float p[3];
+
+	Types::Point_(L, 3, p);
+
+	Grid(L).Set(id, p);
+
+	return 0;
+}
+
+/// Finds items within range of a point
+/// @return Table of IDs, and their count
+/// @remark Arguments: point, max_range[, min_range[, out]]
+/// @remark Batch analogue of script_helpers.IsInRange
+static int WithinRange (lua_State * L)
+{
+	float p[3];
+
+	int arg = Types::Point_(L, 2, p);
+	float maxRange = F(L, arg);
+	float minRange = float(luaL_optnumber(L, arg + 1, 0.0));
+
+	std::vector<SpatialGrid::Hit> hits;
+
+	Grid(L).Gather(p, maxRange, minRange, hits);
+
+	return PushHits(L, hits, hits.size(), arg + 2);
+}
+
+/// Metamethod
+/// @return Count of items in grid
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, Grid(L).mLive);	// grid, count
+
+	return 1;
+}
+
+/// Constructor
+/// @remark Arguments: cell_size[, bucket_count]
+/// @remark The bucket count is rounded up to a power of 2, at most SpatialGrid::eMaxBuckets
+static int Cons (lua_State * L)
+{
+	float cellSize = F(L, 2);
+
+	luaL_argcheck(L, cellSize > 0.0f, 2, "Non-positive cell size");
+
+	lua_Number want = luaL_optnumber(L, 3, 1024);
+
+	luaL_argcheck(L, want > 0 && want <= SpatialGrid::eMaxBuckets, 3, "Bucket count out of range");
+
+	int buckets = 1;
+
+	while (buckets < want) buckets *= 2;
+
+	new (UD(L, 1)) SpatialGrid(cellSize, buckets);
+
+	return 0;
+}
+
+/// Binds the SpatialGrid class
+int Bindings::open_spatialgrid (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Clear", Clear },
+		{ "InCone", InCone },
+		{ "Nearest", Nearest },
+		{ "Rebuild", Rebuild },
+		{ "Remove", Remove },
+		{ "Set", Set },
+		{ "WithinRange", WithinRange },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<SpatialGrid> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "SpatialGrid", methods, Class::Def(sizeof(SpatialGrid)));
+
+	return 0;
+}
\ No newline at end of file
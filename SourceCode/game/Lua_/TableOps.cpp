@@ -0,0 +1,573 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include <cstring>
+
+using namespace Lua;
+
+/// Native versions of the table_ops kernels
+/// @remark Each function that builds a table takes the destination first; if it is @b nil,
+/// a table is created, presized from the source
+/// @remark All table access is raw
+
+/// Supplies the destination table
+/// @param dt Stack index of destination, which is replaced if @b nil
+/// @param t Stack index of source, used to presize a new destination
+static void GetDest (lua_State * L, int dt, int t)
+{
+	if (!lua_isnil(L, dt)) luaL_checktype(L, dt, LUA_TTABLE);
+
+	else
+	{
+		lua_createtable(L, int(lua_objlen(L, t)), 0);	// ..., new_dt
+		lua_replace(L, dt);	// ...
+	}
+}
+
+/// @return If @b true, @e how is the named option
+static bool IsHow (lua_State * L, int how, const char * name)
+{
+	return lua_type(L, how) == LUA_TSTRING && strcmp(lua_tostring(L, how), name) == 0;
+}
+
+/// @return Offset pertinent to the behavior
+static int GetOffset (lua_State * L, int dt, int how)
+{
+	return (IsHow(L, how, "append") ? int(lua_objlen(L, dt)) : 0) + 1;
+}
+
+/// Wipes a range in an array
+/// @param last Stack index of last entry, or 0 to use the array length
+static void WipeRange (lua_State * L, int t, int first, int last)
+{
+	int n = last != 0 && !lua_isnil(L, last) ? int(luaL_checknumber(L, last)) : int(lua_objlen(L, t));
+
+	for (int i = first; i <= n; ++i)
+	{
+		lua_pushnil(L);	// ..., nil
+		lua_rawseti(L, t, i);	// ...
+	}
+}
+
+/// Resolves a table operation
+static void Resolve (lua_State * L, int dt, int how, int offset, int how_arg)
+{
+	if (IsHow(L, how, "overwrite_trim")) WipeRange(L, dt, offset, how_arg);
+}
+
+/// Maps input items to output items
+/// @param map Stack index of mapping function, or 0 for identity
+/// @param bKV If @b true, the key is passed to the mapping function
+static void AuxMap (lua_State * L, int dt, int t, int map, int how, int arg, int how_arg, bool bKV)
+{
+	if (lua_toboolean(L, how))
+	{
+		int offset = GetOffset(L, dt, how);
+
+		for (int i = 1; ; ++i, ++offset)
+		{
+			lua_rawgeti(L, t, i);	// ..., v
+
+			if (lua_isnil(L, -1))
+			{
+				lua_pop(L, 1);	// ...
+
+				break;
+			}
+
+			if (map != 0)
+			{
+				lua_pushvalue(L, map);	// ..., v, map
+
+				if (bKV) lua_pushinteger(L, i);	// ..., v, map, i
+
+				lua_pushvalue(L, -2 - bKV);	// ..., v, map[, i], v
+				lua_pushvalue(L, arg);	// ..., v, map[, i], v, arg
+				lua_call(L, bKV ? 3 : 2, 1);// ..., v, result
+				lua_replace(L, -2);	// ..., result
+			}
+
+			lua_rawseti(L, dt, offset);	// ...
+		}
+
+		Resolve(L, dt, how, offset, how_arg);
+	}
+
+	else
+	{
+		for (lua_pushnil(L); lua_next(L, t); )
+		{
+			int top = lua_gettop(L);
+
+			if (map != 0)
+			{
+				lua_pushvalue(L, map);	// ..., k, v, map
+
+				if (bKV) lua_pushvalue(L, top - 1);	// ..., k, v, map, k
+
+				lua_pushvalue(L, top);	// ..., k, v, map[, k], v
+				lua_pushvalue(L, arg);	// ..., k, v, map[, k], v, arg
+				lua_call(L, bKV ? 3 : 2, 1);// ..., k, v, result
+				lua_replace(L, top);// ..., k, result
+			}
+
+			lua_pushvalue(L, top - 1);	// ..., k, result, k
+			lua_insert(L, top);	// ..., k, k, result
+			lua_rawset(L, dt);	// ..., k
+		}
+	}
+}
+
+/// Shallow-copies a table
+/// @remark Arguments: dt, t[, how[, how_arg]]
+/// @return Copy
+static int Copy (lua_State * L)
+{
+	lua_settop(L, 4);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+	AuxMap(L, 1, 2, 0, 3, 0, 4, false);
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Gives a copy the metatable that getmetatable() reports for its original
+static void CopyMetatable (lua_State * L, int dt, int t)
+{
+	if (luaL_getmetafield(L, dt, "__metatable")) luaL_error(L, "cannot change a protected metatable");
+
+	if (!lua_getmetatable(L, t)) lua_pushnil(L);// ..., nil
+
+	else if (luaL_getmetafield(L, t, "__metatable"))// ..., mt, field
+	{
+		lua_remove(L, -2);	// ..., field
+
+		if (!lua_isnil(L, -1) && !lua_istable(L, -1)) luaL_error(L, "bad argument #2 to 'setmetatable' (nil or table expected)");
+	}
+
+	lua_setmetatable(L, dt);// ...
+}
+
+/// DeepCopy helper
+/// @param guard Stack index of table of copies made so far, keyed by original
+static void AuxDeepCopy (lua_State * L, int dt, int t, int guard)
+{
+	luaL_checkstack(L, 8, "Table nesting too deep");
+
+	lua_pushvalue(L, t);// ..., t
+	lua_pushvalue(L, dt);	// ..., t, dt
+	lua_rawset(L, guard);	// ...
+
+	for (lua_pushnil(L); lua_next(L, t); )
+	{
+		int top = lua_gettop(L);
+
+		if (lua_istable(L, top))
+		{
+			lua_pushvalue(L, top);	// ..., k, v, v
+			lua_rawget(L, guard);	// ..., k, v, copy?
+
+			if (lua_isnil(L, -1))
+			{
+				lua_pop(L, 1);	// ..., k, v
+				lua_createtable(L, int(lua_objlen(L, top)), 0);	// ..., k, v, copy
+
+				AuxDeepCopy(L, top + 1, top, guard);
+			}
+
+			lua_replace(L, top);// ..., k, copy
+		}
+
+		lua_pushvalue(L, top - 1);	// ..., k, v, k
+		lua_insert(L, top);	// ..., k, k, v
+		lua_rawset(L, dt);	// ..., k
+	}
+
+	CopyMetatable(L, dt, t);
+}
+
+/// Deep-copies a table, metatables included
+/// @remark Arguments: dt, t
+/// @return Copy
+static int DeepCopy (lua_State * L)
+{
+	lua_settop(L, 2);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	if (!lua_rawequal(L, 1, 2))
+	{
+		GetDest(L, 1, 2);
+
+		lua_newtable(L);// dt, t, guard
+
+		AuxDeepCopy(L, 1, 2, 3);
+
+		// Fix the case where the table was its own key.
+		lua_pushvalue(L, 2);// dt, t, guard, t
+		lua_rawget(L, 2);	// dt, t, guard, t[t]
+
+		if (!lua_isnil(L, -1))
+		{
+			lua_pushvalue(L, 1);// dt, t, guard, t[t], dt
+			lua_pushvalue(L, 2);// dt, t, guard, t[t], dt, t
+			lua_rawget(L, 1);	// dt, t, guard, t[t], dt, dt[t]
+			lua_rawset(L, 1);	// dt = { ..., [dt] = dt[t] }, t, guard, t[t]
+			lua_pushvalue(L, 2);// dt, t, guard, t[t], t
+			lua_pushnil(L);	// dt, t, guard, t[t], t, nil
+			lua_rawset(L, 1);	// dt = { ..., [t] = nil }, t, guard, t[t]
+		}
+	}
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Equality helper
+static bool AuxEqual (lua_State * L, int t1, int t2)
+{
+	luaL_checkstack(L, 8, "Table nesting too deep");
+
+	int count = 0;
+
+	for (lua_pushnil(L); lua_next(L, t1); ++count)
+	{
+		int top = lua_gettop(L);
+
+		lua_pushvalue(L, top - 1);	// ..., k, v1, k
+		lua_rawget(L, t2);	// ..., k, v1, v2
+
+		int vtype = lua_type(L, top);
+		bool bSame = vtype == lua_type(L, top + 1);
+
+		if (bSame && LUA_TTABLE == vtype) bSame = AuxEqual(L, top, top + 1);
+
+		else if (bSame) bSame = lua_equal(L, top, top + 1) || (LUA_TNUMBER == vtype && lua_tonumber(L, top) != lua_tonumber(L, top) && lua_tonumber(L, top + 1) != lua_tonumber(L, top + 1));
+
+		lua_pop(L, bSame ? 2 : 3);	// ..., k
+
+		if (!bSame) return false;
+	}
+
+	for (lua_pushnil(L); lua_next(L, t2); --count) lua_pop(L, 1);
+
+	return 0 == count;
+}
+
+/// Compares two tables for equality, recursing into subtables
+/// @remark Arguments: t1, t2
+/// @return If @b true, the tables are equal
+static int Equal (lua_State * L)
+{
+	if (!lua_istable(L, 1)) luaL_error(L, "t1 not a table");
+	if (!lua_istable(L, 2)) luaL_error(L, "t2 not a table");
+
+	lua_settop(L, 2);
+	lua_pushboolean(L, AuxEqual(L, 1, 2));	// t1, t2, bEqual
+
+	return 1;
+}
+
+/// Visits each entry of an array in order, removing unwanted entries
+/// @remark Arguments: t, func[, arg[, clear_dead]]
+/// @return Size of table after culling
+static int Filter (lua_State * L)
+{
+	lua_settop(L, 4);
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	int kept = 0, size = 0;
+
+	for (int i = 1; ; ++i)
+	{
+		lua_rawgeti(L, 1, i);	// t, func, arg, clear_dead, v
+
+		if (lua_isnil(L, -1)) break;
+
+		size = i;
+
+		lua_pushvalue(L, 2);// t, func, arg, clear_dead, v, func
+		lua_pushvalue(L, 5);// t, func, arg, clear_dead, v, func, v
+		lua_pushvalue(L, 3);// t, func, arg, clear_dead, v, func, v, arg
+		lua_call(L, 2, 1);	// t, func, arg, clear_dead, v, result
+
+		// Put keepers back into the table. If desired, empty the table first.
+		if (lua_toboolean(L, 6))
+		{
+			bool bEmpty = lua_type(L, 6) == LUA_TNUMBER && lua_tonumber(L, 6) == 0;
+
+			kept = (bEmpty ? 0 : kept) + 1;
+
+			lua_pushvalue(L, 5);// t, func, arg, clear_dead, v, result, v
+			lua_rawseti(L, 1, kept);// t, func, arg, clear_dead, v, result
+		}
+
+		lua_settop(L, 4);	// t, func, arg, clear_dead
+	}
+
+	// Wipe dead entries or place a sentinel nil.
+	for (int i = kept + 1, last = lua_toboolean(L, 4) ? size : kept + 1; i <= last; ++i)
+	{
+		lua_pushnil(L);	// t, func, arg, clear_dead, v, nil
+		lua_rawseti(L, 1, i);	// t, func, arg, clear_dead, v
+	}
+
+	lua_pushinteger(L, kept);	// t, func, arg, clear_dead, v, kept
+
+	return 1;
+}
+
+/// Finds a match for a value in the table, respecting @b __eq
+/// @remark Arguments: t, value[, is_array]
+/// @return Key belonging to a match, or nothing if the value was not found
+static int Find (lua_State * L)
+{
+	lua_settop(L, 3);
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	if (lua_toboolean(L, 3))
+	{
+		for (int i = 1; ; ++i)
+		{
+			lua_rawgeti(L, 1, i);	// t, value, is_array, v
+
+			if (lua_isnil(L, 4)) return 0;
+
+			if (lua_equal(L, 4, 2))
+			{
+				lua_pushinteger(L, i);	// t, value, is_array, v, i
+
+				return 1;
+			}
+
+			lua_pop(L, 1);	// t, value, is_array
+		}
+	}
+
+	for (lua_pushnil(L); lua_next(L, 1); lua_pop(L, 1))
+	{
+		if (lua_equal(L, 5, 2))
+		{
+			lua_pop(L, 1);	// t, value, is_array, k
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// Appends all keys, arbitrarily ordered, to an array
+/// @remark Arguments: dt, t
+/// @return Key array
+static int GetKeys (lua_State * L)
+{
+	lua_settop(L, 2);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+
+	int n = int(lua_objlen(L, 1));
+
+	for (lua_pushnil(L); lua_next(L, 2); )
+	{
+		lua_pop(L, 1);	// dt, t, k
+		lua_pushvalue(L, 3);// dt, t, k, k
+		lua_rawseti(L, 1, ++n);	// dt = { ..., k }, t, k
+	}
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Builds a table's inverse
+/// @remark Arguments: dt, t
+/// @return Inverse table
+static int Invert (lua_State * L)
+{
+	lua_settop(L, 2);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+
+	if (lua_equal(L, 1, 2)) luaL_error(L, "Invert: Table cannot be its own destination");
+
+	for (lua_pushnil(L); lua_next(L, 2); lua_pop(L, 1))
+	{
+		lua_pushvalue(L, 4);// dt, t, k, v, v
+		lua_pushvalue(L, 3);// dt, t, k, v, v, k
+		lua_rawset(L, 1);	// dt = { ..., [v] = k }, t, k, v
+	}
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Makes a set from an array's values
+/// @remark Arguments: dt, t
+/// @return Set
+static int MakeSet (lua_State * L)
+{
+	lua_settop(L, 2);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	if (lua_isnil(L, 1))
+	{
+		lua_createtable(L, 0, int(lua_objlen(L, 2)));	// nil, t, dt
+		lua_replace(L, 1);	// dt, t
+	}
+
+	GetDest(L, 1, 2);
+
+	for (int i = 1; ; ++i)
+	{
+		lua_rawgeti(L, 2, i);	// dt, t, v
+
+		if (lua_isnil(L, 3)) break;
+
+		lua_pushboolean(L, 1);	// dt, t, v, true
+		lua_rawset(L, 1);	// dt = { ..., [v] = true }, t
+	}
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Maps input items to output items
+/// @remark Arguments: dt, t, map[, how[, arg[, how_arg]]]
+/// @return Mapped table
+static int Map (lua_State * L)
+{
+	lua_settop(L, 6);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+	AuxMap(L, 1, 2, 3, 4, 5, 6, false);
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Key-value variant of Map
+/// @remark Arguments: dt, t, map[, how[, arg[, how_arg]]]
+/// @return Mapped table
+static int MapKV (lua_State * L)
+{
+	lua_settop(L, 6);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+	AuxMap(L, 1, 2, 3, 4, 5, 6, true);
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Moves items into a second table
+/// @remark Arguments: dt, t[, how[, how_arg]]
+/// @return Destination table
+static int Move (lua_State * L)
+{
+	lua_settop(L, 4);
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	GetDest(L, 1, 2);
+
+	if (lua_rawequal(L, 1, 2))
+	{
+		lua_settop(L, 1);	// dt
+
+		return 1;
+	}
+
+	if (lua_toboolean(L, 3))
+	{
+		int offset = GetOffset(L, 1, 3);
+
+		for (int i = 1; ; ++i, ++offset)
+		{
+			lua_rawgeti(L, 2, i);	// dt, t, how, how_arg, v
+
+			if (lua_isnil(L, 5)) break;
+
+			lua_rawseti(L, 1, offset);	// dt = { ..., [offset] = v }, t, how, how_arg
+			lua_pushnil(L);	// dt, t, how, how_arg, nil
+			lua_rawseti(L, 2, i);	// dt, t = { ..., [i] = nil }, how, how_arg
+		}
+
+		lua_pop(L, 1);	// dt, t, how, how_arg
+
+		Resolve(L, 1, 3, offset, 4);
+	}
+
+	else
+	{
+		for (lua_pushnil(L); lua_next(L, 2); )
+		{
+			lua_pushvalue(L, 5);// dt, t, how, how_arg, k, v, k
+			lua_insert(L, 6);	// dt, t, how, how_arg, k, k, v
+			lua_rawset(L, 1);	// dt = { ..., [k] = v }, t, how, how_arg, k
+			lua_pushvalue(L, 5);// dt, t, how, how_arg, k, k
+			lua_pushnil(L);	// dt, t, how, how_arg, k, k, nil
+			lua_rawset(L, 2);	// dt, t = { ..., [k] = nil }, how, how_arg, k
+		}
+	}
+
+	lua_settop(L, 1);
+
+	return 1;
+}
+
+/// Reverses table elements in-place, in the range [1, count]
+/// @remark Arguments: t[, count]
+static int Reverse (lua_State * L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	for (int i = 1, j = lua_isnoneornil(L, 2) ? int(lua_objlen(L, 1)) : int(luaL_checknumber(L, 2)); i < j; ++i, --j)
+	{
+		lua_rawgeti(L, 1, i);	// t, count, t[i]
+		lua_rawgeti(L, 1, j);	// t, count, t[i], t[j]
+		lua_rawseti(L, 1, i);	// t = { ..., [i] = t[j] }, count, t[i]
+		lua_rawseti(L, 1, j);	// t = { ..., [j] = t[i] }, count
+	}
+
+	return 0;
+}
+
+/// Registers the table_ops_native library
+/// @remark Binding this is optional; if present, table_ops uses it for its hot functions
+/// unless told otherwise at boot
+int Bindings::open_tableops (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Copy", Copy },
+		{ "DeepCopy", DeepCopy },
+		{ "Equal", Equal },
+		{ "Filter", Filter },
+		{ "Find", Find },
+		{ "GetKeys", GetKeys },
+		{ "Invert", Invert },
+		{ "MakeSet", MakeSet },
+		{ "Map", Map },
+		{ "MapKV", MapKV },
+		{ "Move", Move },
+		{ "Reverse", Reverse },
+		{ 0, 0 }
+	};
+
+	Register(L, "table_ops_native", funcs);
+
+	return 0;
+}
\ No newline at end of file
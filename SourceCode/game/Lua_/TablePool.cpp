@@ -0,0 +1,333 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+
+using namespace Lua;
+
+/// Shared pool of recycled tables, binned by size class
+/// @remark The Lua API does not expose table capacities, so a table's class is estimated
+/// from its contents on return: array length and hash entry count, each rounded up to a
+/// power of 2, which is how the tables grow. Tables too big for any class are let go,
+/// so that a burst of large tables does not pin memory, and small requests never receive
+/// a huge table.
+/// @remark Buckets live in the library environment, keyed by class index
+struct TablePool {
+	enum {
+		eArrayClasses = 12,	///< Array classes: 0, 1, 2, 4, ..., 1024 slots
+		eHashClasses = 10,	///< Hash classes: 0, 1, 2, 4, ..., 256 nodes
+		eSpan = 2,	///< Classes above a request's own that may serve it
+		eTableBytes = 56,	///< Estimated size of a table header
+		eSlotBytes = 16,///< Estimated size of an array slot
+		eNodeBytes = 40	///< Estimated size of a hash node
+	};
+
+	int mCounts[eArrayClasses * eHashClasses];	///< Tables retained per class
+	int mLimit;	///< Maximum tables retained per class
+	double mHits;	///< Requests served from the pool
+	double mMisses;	///< Requests served by a new table
+	double mDiscards;	///< Returned tables not retained
+	double mRetainedBytes;	///< Estimated memory held by retained tables
+
+	TablePool (void) : mLimit(32), mHits(0), mMisses(0), mDiscards(0), mRetainedBytes(0)
+	{
+		for (int i = 0; i < eArrayClasses * eHashClasses; ++i) mCounts[i] = 0;
+	}
+
+	/// @return Class of a size, or -1 if beyond the last class
+	static int Class (int size, int nclasses)
+	{
+		int c = 0;
+
+		for (int cap = 0; cap < size; cap = cap ? cap * 2 : 1) ++c;
+
+		return c < nclasses ? c : -1;
+	}
+
+	/// @return Estimated memory held by a table of the given class
+	static double Bytes (int ca, int ch)
+	{
+		return eTableBytes + eSlotBytes * (ca ? 1 << (ca - 1) : 0) + eNodeBytes * (ch ? 1 << (ch - 1) : 0);
+	}
+};
+
+/// @return Pool state
+static TablePool & Pool (lua_State * L)
+{
+	lua_getfield(L, LUA_ENVIRONINDEX, "state");	// ..., state
+
+	TablePool * pool = (TablePool *)lua_touserdata(L, -1);
+
+	lua_pop(L, 1);	// ...
+
+	return *pool;
+}
+
+/// Pushes a class's bucket
+static void PushBucket (lua_State * L, int ca, int ch)
+{
+	lua_rawgeti(L, LUA_ENVIRONINDEX, ca * TablePool::eHashClasses + ch + 1);	// ..., bucket
+}
+
+/// Empties a table and, if it fits a class with room, retains it
+/// @param t Stack index of table
+/// @param narr If positive, array size to assume, when the table was already partly wiped
+static void AuxPut (lua_State * L, TablePool & pool, int t, int narr)
+{
+	// Weak or protected tables are not recycled; any other metatable is simply removed.
+	if (lua_getmetatable(L, t))	// ...[, mt]
+	{
+		lua_getfield(L, -1, "__mode");	// ..., mt, mode
+		lua_getfield(L, -2, "__metatable");	// ..., mt, mode, protected
+
+		bool bKeep = lua_isnil(L, -1) && lua_isnil(L, -2);
+
+		lua_pop(L, 3);	// ...
+
+		if (!bKeep)
+		{
+			++pool.mDiscards;
+
+			return;
+		}
+
+		lua_pushnil(L);	// ..., nil
+		lua_setmetatable(L, t);	// ...
+	}
+
+	// Size the table and empty it in the same pass.
+	int n = int(lua_objlen(L, t)), nrec = 0;
+
+	for (lua_pushnil(L); lua_next(L, t); )
+	{
+		lua_pop(L, 1);	// ..., k
+
+		if (lua_type(L, -1) != LUA_TNUMBER || lua_tonumber(L, -1) != lua_Number(lua_tointeger(L, -1)) || lua_tointeger(L, -1) < 1 || lua_tointeger(L, -1) > n) ++nrec;
+
+		lua_pushvalue(L, -1);	// ..., k, k
+		lua_pushnil(L);	// ..., k, k, nil
+		lua_rawset(L, t);	// ..., k
+	}
+
+	int ca = TablePool::Class(narr > n ? narr : n, TablePool::eArrayClasses), ch = TablePool::Class(nrec, TablePool::eHashClasses);
+
+	if (ca < 0 || ch < 0 || pool.mCounts[ca * TablePool::eHashClasses + ch] >= pool.mLimit)
+	{
+		++pool.mDiscards;
+
+		return;
+	}
+
+	int & count = pool.mCounts[ca * TablePool::eHashClasses + ch];
+
+	PushBucket(L, ca, ch);	// ..., bucket
+	lua_pushvalue(L, t);// ..., bucket, t
+	lua_rawseti(L, -2, ++count);// ..., bucket = { ..., t }
+	lua_pop(L, 1);	// ...
+
+	pool.mRetainedBytes += TablePool::Bytes(ca, ch);
+}
+
+/// Drops retained tables beyond a count in every class
+static void Trim (lua_State * L, TablePool & pool, int keep)
+{
+	for (int ca = 0; ca < TablePool::eArrayClasses; ++ca)
+	{
+		for (int ch = 0; ch < TablePool::eHashClasses; ++ch)
+		{
+			int & count = pool.mCounts[ca * TablePool::eHashClasses + ch];
+
+			if (count <= keep) continue;
+
+			PushBucket(L, ca, ch);	// ..., bucket
+
+			for (; count > keep; --count)
+			{
+				lua_pushnil(L);	// ..., bucket, nil
+				lua_rawseti(L, -2, count);	// ..., bucket = { ..., nil }
+
+				pool.mRetainedBytes -= TablePool::Bytes(ca, ch);
+			}
+
+			lua_pop(L, 1);	// ...
+		}
+	}
+}
+
+/// Drops all retained tables
+static int Clear (lua_State * L)
+{
+	Trim(L, Pool(L), 0);
+
+	return 0;
+}
+
+/// Takes a retained table out of a class's bucket
+static void Take (lua_State * L, TablePool & pool, int ca, int ch)
+{
+	int & count = pool.mCounts[ca * TablePool::eHashClasses + ch];
+
+	PushBucket(L, ca, ch);	// ..., bucket
+	lua_rawgeti(L, -1, count);	// ..., bucket, t
+	lua_pushnil(L);	// ..., bucket, t, nil
+	lua_rawseti(L, -3, count--);// ..., bucket = { ..., nil }, t
+
+	++pool.mHits;
+
+	pool.mRetainedBytes -= TablePool::Bytes(ca, ch);
+}
+
+/// Supplies an empty table
+/// @remark Arguments: [narr[, nrec]]
+/// @remark With size hints, a retained table is used if one of the class of the requested
+/// sizes, or of the few classes above it, is available; without them, the smallest retained
+/// table of any class is used. Otherwise, a new one is made, with the requested sizes.
+/// @return Table
+static int Get (lua_State * L)
+{
+	TablePool & pool = Pool(L);
+
+	if (lua_isnoneornil(L, 1) && lua_isnoneornil(L, 2))
+	{
+		int best = -1;
+
+		for (int i = 0; i < TablePool::eArrayClasses * TablePool::eHashClasses; ++i)
+		{
+			if (0 == pool.mCounts[i]) continue;
+
+			if (best < 0 || TablePool::Bytes(i / TablePool::eHashClasses, i % TablePool::eHashClasses) < TablePool::Bytes(best / TablePool::eHashClasses, best % TablePool::eHashClasses)) best = i;
+		}
+
+		if (best >= 0)
+		{
+			Take(L, pool, best / TablePool::eHashClasses, best % TablePool::eHashClasses);	// ..., t
+
+			return 1;
+		}
+	}
+
+	int narr = luaL_optint(L, 1, 0), nrec = luaL_optint(L, 2, 0);
+	int ca = TablePool::Class(narr, TablePool::eArrayClasses), ch = TablePool::Class(nrec, TablePool::eHashClasses);
+
+	if (ca >= 0 && ch >= 0)
+	{
+		for (int a = ca; a <= ca + TablePool::eSpan && a < TablePool::eArrayClasses; ++a)
+		{
+			for (int h = ch; h <= ch + TablePool::eSpan && h < TablePool::eHashClasses; ++h)
+			{
+				if (0 == pool.mCounts[a * TablePool::eHashClasses + h]) continue;
+
+				Take(L, pool, a, h);// ..., t
+
+				return 1;
+			}
+		}
+	}
+
+	++pool.mMisses;
+
+	lua_createtable(L, narr, nrec);	// ..., t
+
+	return 1;
+}
+
+/// @return Hits, misses, discards, retained count, retained bytes (estimated)
+static int GetStats (lua_State * L)
+{
+	TablePool & pool = Pool(L);
+
+	int retained = 0;
+
+	for (int i = 0; i < TablePool::eArrayClasses * TablePool::eHashClasses; ++i) retained += pool.mCounts[i];
+
+	lua_pushnumber(L, pool.mHits);	// hits
+	lua_pushnumber(L, pool.mMisses);// hits, misses
+	lua_pushnumber(L, pool.mDiscards);	// hits, misses, discards
+	lua_pushinteger(L, retained);	// hits, misses, discards, retained
+	lua_pushnumber(L, pool.mRetainedBytes);	// hits, misses, discards, retained, bytes
+
+	return 5;
+}
+
+/// Empties a table and returns it to the pool
+/// @remark Arguments: t[, narr]
+/// @remark If supplied, @e narr is the array size to assume, when the table was already
+/// wiped, at least in part
+static int Put (lua_State * L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	AuxPut(L, Pool(L), 1, luaL_optint(L, 2, 0));
+
+	return 0;
+}
+
+/// Returns a table's array values, then empties the table and returns it to the pool
+/// @remark Arguments: t[, count]
+/// @return Array values (number of return values = @e count, by default #t)
+static int PutAndUnpack (lua_State * L)
+{
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	int count = lua_isnoneornil(L, 2) ? int(lua_objlen(L, 1)) : sI(L, 2);
+
+	luaL_checkstack(L, count, "Too many results");
+
+	lua_settop(L, 1);	// t
+
+	for (int i = 1; i <= count; ++i) lua_rawgeti(L, 1, i);	// t, ...
+
+	AuxPut(L, Pool(L), 1, count);
+
+	return count;
+}
+
+/// Sets the maximum number of tables retained per class, dropping any excess
+/// @remark Arguments: limit
+static int SetLimit (lua_State * L)
+{
+	TablePool & pool = Pool(L);
+
+	pool.mLimit = luaL_checkint(L, 1);
+
+	if (pool.mLimit < 0) pool.mLimit = 0;
+
+	Trim(L, pool, pool.mLimit);
+
+	return 0;
+}
+
+/// Registers the table_pool library
+int Bindings::open_tablepool (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Clear", Clear },
+		{ "Get", Get },
+		{ "GetStats", GetStats },
+		{ "Put", Put },
+		{ "PutAndUnpack", PutAndUnpack },
+		{ "SetLimit", SetLimit },
+		{ 0, 0 }
+	};
+
+	// Build the environment: the pool state and one bucket per class.
+	lua_createtable(L, TablePool::eArrayClasses * TablePool::eHashClasses, 1);	// env
+
+	new (lua_newuserdata(L, sizeof(TablePool))) TablePool;	// env, state
+
+	lua_setfield(L, -2, "state");	// env = { state = state }
+
+	for (int i = 1; i <= TablePool::eArrayClasses * TablePool::eHashClasses; ++i)
+	{
+		lua_newtable(L);// env, bucket
+		lua_rawseti(L, -2, i);	// env = { ..., bucket }
+	}
+
+	Register(L, "table_pool", funcs, -1);
+
+	lua_pop(L, 1);
+
+	return 0;
+}
\ No newline at end of file
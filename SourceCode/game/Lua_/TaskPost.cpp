@@ -0,0 +1,126 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/TaskPost.h"
+#include <map>
+#include <string>
+
+using namespace Lua;
+
+/// @return Named post queues
+static std::map<std::string, TaskPostQueue *> & Queues (void)
+{
+	static std::map<std::string, TaskPostQueue *> sQueues;
+
+	return sQueues;
+}
+
+/// Gets a named post queue
+/// @param name Queue name
+/// @return Queue, or @b NULL if it was never opened
+/// @remark This only reads the queue registry, so it is safe from any thread as long as no
+/// queue is being opened at the same time. Worker threads should look up their queues once
+/// the main thread has opened them all during setup, and keep the pointers.
+TaskPostQueue * Lua::GetTaskPostQueue (const char * name)
+{
+	std::map<std::string, TaskPostQueue *>::const_iterator iter = Queues().find(name);
+
+	return iter != Queues().end() ? iter->second : 0;
+}
+
+/// Gets a named post queue, creating it if necessary
+/// @param name Queue name
+/// @param capacity Ring capacity, if the queue is created
+/// @return Queue, which lives until shutdown
+/// @remark This modifies the queue registry, so it must be called from the main thread,
+/// before other threads start looking up queues
+TaskPostQueue * Lua::OpenTaskPostQueue (const char * name, unsigned long capacity)
+{
+	TaskPostQueue *& queue = Queues()[name];
+
+	if (0 == queue) queue = new TaskPostQueue(capacity);
+
+	return queue;
+}
+
+/// @return Queue named by an argument
+/// @remark It is an error if the queue was never opened
+static TaskPostQueue * CheckQueue (lua_State * L, int index)
+{
+	const char * name = luaL_checkstring(L, index);
+
+	TaskPostQueue * queue = GetTaskPostQueue(name);
+
+	if (0 == queue) luaL_error(L, "Task post queue \"%s\" was never opened", name);
+
+	return queue;
+}
+
+/// Takes every post out of a queue
+/// @remark Arguments: name[, tasks_out[, args_out]]
+/// @return Table of task IDs, table of task arguments, and the count of posts
+static int Drain (lua_State * L)
+{
+	lua_settop(L, 3);
+
+	TaskPostQueue * queue = CheckQueue(L, 1);
+
+	PrepOutTable(L, 2, 0);	// name, tasks_out, args_out, tasks
+	PrepOutTable(L, 3, 0);	// name, tasks_out, args_out, tasks, args
+
+	int count = 0;
+
+	for (int task, arg; queue->Drain(task, arg); )
+	{
+		lua_pushinteger(L, task);	// name, tasks_out, args_out, tasks, args, task
+		lua_rawseti(L, 4, ++count);	// name, tasks_out, args_out, tasks = { ..., task }, args
+		lua_pushinteger(L, arg);// name, tasks_out, args_out, tasks, args, arg
+		lua_rawseti(L, 5, count);	// name, tasks_out, args_out, tasks, args = { ..., arg }
+	}
+
+	lua_pushinteger(L, count);	// name, tasks_out, args_out, tasks, args, count
+
+	return 3;
+}
+
+/// Creates a post queue ahead of use
+/// @remark Arguments: name[, capacity]
+/// @remark @e capacity must be in [1, 2^30]; it is ignored if the queue already exists
+static int Open (lua_State * L)
+{
+	lua_Number capacity = luaL_optnumber(L, 2, 1024);
+
+	luaL_argcheck(L, capacity >= 1 && capacity <= TaskPostQueue::eMaxCapacity, 2, "Capacity must be in [1, 2^30]");
+
+	OpenTaskPostQueue(luaL_checkstring(L, 1), (unsigned long)capacity);
+
+	return 0;
+}
+
+/// Posts a task from the main thread
+/// @remark Arguments: name, task, arg
+/// @return If @b true, the task was posted
+static int Post (lua_State * L)
+{
+	lua_pushboolean(L, CheckQueue(L, 1)->Post(sI(L, 2), luaL_optint(L, 3, 0)));	// name, task, arg, bPosted
+
+	return 1;
+}
+
+/// Registers the task_post library
+int Bindings::open_taskpost (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Drain", Drain },
+		{ "Open", Open },
+		{ "Post", Post },
+		{ 0, 0 }
+	};
+
+	Register(L, "task_post", funcs);
+
+	return 0;
+}
\ No newline at end of file
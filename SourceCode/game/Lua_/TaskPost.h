@@ -0,0 +1,143 @@
+#ifndef LUA_TASK_POST_H
+#define LUA_TASK_POST_H
+
+#include "Lua_/Lua.h"
+#include <vector>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace Lua
+{
+	/*%%%%%%%%%%%%%%%% TASK POSTING %%%%%%%%%%%%%%%%*/
+
+	/// Bounded multiple-producer, single-consumer ring of task posts
+	/// @remark Any thread may call Post(); it never blocks and never touches a lua_State
+	/// @remark Only the main thread may call Drain()
+	/// @remark Positions are unsigned and wrap around; they are only ever compared through
+	/// their differences, which stay well-defined across the wrap
+	class TaskPostQueue {
+		/// Ring cell
+		struct Cell {
+			volatile unsigned long mSequence;	///< Position of post that may next use the cell
+			int mTask;	///< Task ID, to be mapped to a Lua task by the consumer
+			int mArg;	///< Task argument
+		};
+
+		std::vector<Cell> mCells;	///< Ring of cells
+		unsigned long mMask;///< Cell count - 1
+		volatile unsigned long mEnqueue;///< Next position to post
+		unsigned long mDequeue;	///< Next position to drain
+
+		/// @return Value, read with acquire semantics
+		static unsigned long Load (volatile unsigned long & value)
+		{
+		#ifdef _MSC_VER
+			return value;	// volatile reads acquire under MSVC
+		#else
+			return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+		#endif
+		}
+
+		/// Writes a value with release semantics
+		static void Store (volatile unsigned long & value, unsigned long what)
+		{
+		#ifdef _MSC_VER
+			value = what;	// volatile writes release under MSVC
+		#else
+			__atomic_store_n(&value, what, __ATOMIC_RELEASE);
+		#endif
+		}
+
+		/// @return If @b true, @e value was @e expected and is now @e what
+		static bool CompareAndSwap (volatile unsigned long & value, unsigned long expected, unsigned long what)
+		{
+		#ifdef _MSC_VER
+			return _InterlockedCompareExchange((volatile long *)&value, long(what), long(expected)) == long(expected);
+		#else
+			return __sync_bool_compare_and_swap(&value, expected, what);
+		#endif
+		}
+
+	public:
+		enum { eMaxCapacity = 1 << 30 };	///< Largest ring capacity
+
+		/// @param capacity Ring capacity, rounded up to a power of 2, at most eMaxCapacity
+		TaskPostQueue (unsigned long capacity) : mEnqueue(0), mDequeue(0)
+		{
+			unsigned long size = 2;
+
+			while (size < capacity && size < eMaxCapacity) size *= 2;
+
+			mCells.resize(size);
+			mMask = size - 1;
+
+			for (unsigned long i = 0; i < size; ++i) mCells[i].mSequence = i;
+		}
+
+		/// Posts a task
+		/// @param task Task ID
+		/// @param arg Task argument
+		/// @return If @b false, the ring is full and the post was dropped
+		bool Post (int task, int arg)
+		{
+			unsigned long pos = Load(mEnqueue);
+
+			for (;;)
+			{
+				Cell & cell = mCells[pos & mMask];
+
+				// How far the cell lags this position: not at all if it is free for it, by up
+				// to a lap if its last post is still undrained (the ring is full), and by a
+				// wrapped-around "negative" amount if another producer already claimed it.
+				unsigned long lag = pos - Load(cell.mSequence);
+
+				// The cell is free for this position: try to claim it. Otherwise, either the
+				// ring is full or another producer got here first.
+				if (0 == lag)
+				{
+					if (CompareAndSwap(mEnqueue, pos, pos + 1))
+					{
+						cell.mTask = task;
+						cell.mArg = arg;
+
+						Store(cell.mSequence, pos + 1);
+
+						return true;
+					}
+				}
+
+				else if (lag <= mMask + 1) return false;
+
+				pos = Load(mEnqueue);
+			}
+		}
+
+		/// Takes the next task post
+		/// @param task [out] Task ID
+		/// @param arg [out] Task argument
+		/// @return If @b false, the ring was empty
+		bool Drain (int & task, int & arg)
+		{
+			Cell & cell = mCells[mDequeue & mMask];
+
+			// With a single consumer, the cell is either posted for this position or still free.
+			if (Load(cell.mSequence) != mDequeue + 1) return false;
+
+			task = cell.mTask;
+			arg = cell.mArg;
+
+			Store(cell.mSequence, mDequeue + mMask + 1);
+
+			++mDequeue;
+
+			return true;
+		}
+	};
+
+	G2GAME_IMPEXP TaskPostQueue * GetTaskPostQueue (const char * name);
+	G2GAME_IMPEXP TaskPostQueue * OpenTaskPostQueue (const char * name, unsigned long capacity = 1024);
+}
+
+#endif // LUA_TASK_POST_H
\ No newline at end of file
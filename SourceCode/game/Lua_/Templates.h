@@ -1,6 +1,8 @@
 #ifndef LUA_TEMPLATES_H
 #define LUA_TEMPLATES_H
 
+#include "Lua_/Handles.h"
+
 namespace Lua
 {
 	/*%%%%%%%%%%%%%%%% TEMPLATED HELPER FUNCTIONS %%%%%%%%%%%%%%%%*/
@@ -25,6 +27,9 @@ namespace Lua
 			// If the instance is a boxed T, look up its memory.
 			if (Class::IsType(L, index, luaT_boxed_type<T>())) return luaT_boxed_get<T>(L, index);
 
+			// If T has a handle type and the instance is one, look up its object.
+			if (*luaT_handle_type<T>() != '\0' && Class::IsType(L, index, luaT_handle_type<T>())) return luaT_handle_ptr<T>(L, index);
+
 			// Otherwise, point to its memory.
 			if (!Class::IsType(L, index, luaT_type<T>())) luaL_error(L, "Arg #%d: non-%s / %s", index, luaT_type<T>(), luaT_boxed_type<T>());
 		}
@@ -0,0 +1,510 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <emmintrin.h>
+
+using namespace Lua;
+
+/// Structure-of-arrays storage for timers, as per the Timer class
+/// @remark Arrays are padded with idle slots to a multiple of the SIMD width
+struct TimerBank {
+	enum { eWidth = 2 };///< SIMD lane count
+
+	std::vector<double> mDuration;	///< Timeout durations; 0 if stopped
+	std::vector<double> mCounter;	///< Counters
+	std::vector<double> mOffset;///< Counter values at last check
+	std::vector<double> mRate;	///< 1 if running and unpaused, else 0
+	std::vector<unsigned char> mPaused;	///< If nonzero, timer is paused
+	std::vector<unsigned char> mLive;	///< If nonzero, slot is allocated
+	std::vector<int> mFree;	///< Free slots
+	std::vector<int> mFired;///< Slots that timed out during the last check
+	std::vector<double> mLaps;	///< Timeout counts of fired slots
+
+	/// Refreshes a slot's rate after a change of duration or pause state
+	void SetRate (size_t slot)
+	{
+		mRate[slot] = mDuration[slot] > 0.0 && !mPaused[slot] ? 1.0 : 0.0;
+	}
+
+	/// Claims a stopped, unpaused slot
+	/// @return Slot index
+	size_t Alloc (void)
+	{
+		if (!mFree.empty())
+		{
+			size_t slot = size_t(mFree.back());
+
+			mFree.pop_back();
+
+			mLive[slot] = 1;
+
+			return slot;
+		}
+
+		// Grow by a full lane, and put any padding on the free list.
+		size_t slot = mDuration.size();
+
+		mDuration.resize(slot + eWidth, 0.0);
+		mCounter.resize(slot + eWidth, 0.0);
+		mOffset.resize(slot + eWidth, 0.0);
+		mRate.resize(slot + eWidth, 0.0);
+		mPaused.resize(slot + eWidth, 0);
+		mLive.resize(slot + eWidth, 0);
+
+		for (size_t i = slot + eWidth - 1; i > slot; --i) mFree.push_back(int(i));
+
+		mLive[slot] = 1;
+
+		return slot;
+	}
+
+	/// Starts a slot's timer, as per Timer:Start
+	void Start (size_t slot, double duration, double t)
+	{
+		mDuration[slot] = duration;
+		mCounter[slot] = t;
+		mOffset[slot] = t - std::floor(t / duration) * duration;
+		mPaused[slot] = 0;
+
+		SetRate(slot);
+	}
+
+	/// Stops a slot and returns it to the free list
+	/// @return If @b false, the slot was already free, and is left alone
+	bool Free (size_t slot)
+	{
+		if (!mLive[slot]) return false;
+
+		mDuration[slot] = mCounter[slot] = mOffset[slot] = mRate[slot] = 0.0;
+		mPaused[slot] = mLive[slot] = 0;
+
+		mFree.push_back(int(slot));
+
+		return true;
+	}
+
+	/// Advances every running, unpaused timer
+	/// @param step Time step
+	void Update (double step)
+	{
+		if (mCounter.empty()) return;
+
+		double * pCounter = &mCounter[0];
+		const double * pRate = &mRate[0];
+		__m128d vStep = _mm_set1_pd(step);
+
+		for (size_t i = 0; i < mCounter.size(); i += eWidth)
+		{
+			__m128d counter = _mm_loadu_pd(pCounter + i);
+
+			_mm_storeu_pd(pCounter + i, _mm_add_pd(counter, _mm_mul_pd(vStep, _mm_loadu_pd(pRate + i))));
+		}
+	}
+
+	/// Checks one slot for timeouts, as per Timer:Check
+	/// @param slot Slot index
+	/// @param how 0 = stop, 1 = continue, 2 = pause
+	/// @return Timeout count
+	double Check (size_t slot, int how)
+	{
+		double count = 0.0;
+
+		if (mRate[slot] > 0.0 && mCounter[slot] >= mDuration[slot])
+		{
+			if (1 == how)
+			{
+				double quotient = mCounter[slot] / mDuration[slot];
+
+				count = std::floor(quotient);
+
+				mCounter[slot] = (quotient - count) * mDuration[slot];
+			}
+
+			else if (2 == how)
+			{
+				count = 1.0;
+
+				mCounter[slot] = 0.0;
+				mPaused[slot] = 1;
+			}
+
+			else
+			{
+				count = 1.0;
+
+				mDuration[slot] = 0.0;
+			}
+
+			mOffset[slot] = mCounter[slot];
+
+			SetRate(slot);
+		}
+
+		return count;
+	}
+
+	/// Checks every timer, collecting the ones that timed out
+	/// @param how As per Check()
+	void CheckAll (int how)
+	{
+		mFired.clear();
+		mLaps.clear();
+
+		if (mCounter.empty()) return;
+
+		const double * pCounter = &mCounter[0], * pDuration = &mDuration[0], * pRate = &mRate[0];
+
+		for (size_t i = 0; i < mCounter.size(); i += eWidth)
+		{
+			__m128d due = _mm_cmpge_pd(_mm_loadu_pd(pCounter + i), _mm_loadu_pd(pDuration + i));
+			__m128d live = _mm_cmpgt_pd(_mm_loadu_pd(pRate + i), _mm_setzero_pd());
+			int mask = _mm_movemask_pd(_mm_and_pd(due, live));
+
+			for (int j = 0; mask != 0; ++j, mask >>= 1)
+			{
+				if (mask & 1)
+				{
+					mFired.push_back(int(i + j));
+					mLaps.push_back(Check(i + j, how));
+				}
+			}
+		}
+	}
+};
+
+namespace Lua
+{
+	/// TimerBank type name
+	template<> const char * luaT_type<TimerBank> (void) { return "TimerBank"; }
+}
+
+/// Timeout responses, as per Timer:Check
+static const char * sHow[] = { "stop", "continue", "pause", 0 };
+
+/// Reads a timeout response
+/// @param index Stack index; anything other than @b "continue" or @b "pause" means stop
+/// @return Response index, as per TimerBank::Check()
+static int How (lua_State * L, int index)
+{
+	const char * how = lua_isstring(L, index) ? lua_tostring(L, index) : "";
+
+	for (int i = 1; sHow[i] != 0; ++i)
+	{
+		if (strcmp(how, sHow[i]) == 0) return i;
+	}
+
+	return 0;
+}
+
+/// Validates a slot argument
+/// @param index Stack index of slot, as returned by Alloc()
+/// @return 0-based slot index
+static size_t Slot (lua_State * L, TimerBank & B, int index)
+{
+	int slot = sI(L, index) - 1;
+
+	luaL_argcheck(L, slot >= 0 && size_t(slot) < B.mDuration.size(), index, "Invalid slot");
+
+	return size_t(slot);
+}
+
+/// Claims a slot for a new timer, which begins stopped and unpaused
+/// @return Slot
+static int Alloc (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(luaT_ref<TimerBank>(L, 1).Alloc() + 1));	// B, slot
+
+	return 1;
+}
+
+/// Checks every timer in the bank for timeouts
+/// @remark Arguments: how[, slots_out[, counts_out]]
+/// @remark @e how is as per Timer:Check
+/// @return Table of slots that timed out, table of their timeout counts, and the count of slots
+static int Check (lua_State * L)
+{
+	lua_settop(L, 4);
+
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	B.CheckAll(How(L, 2));
+
+	PrepOutTable(L, 3, int(B.mFired.size()));	// B, how, slots_out, counts_out, slots
+	PrepOutTable(L, 4, int(B.mFired.size()));	// B, how, slots_out, counts_out, slots, counts
+
+	for (size_t i = 0; i < B.mFired.size(); ++i)
+	{
+		lua_pushinteger(L, B.mFired[i] + 1);// B, how, slots_out, counts_out, slots, counts, slot
+		lua_rawseti(L, 5, int(i + 1));	// B, how, slots_out, counts_out, slots = { ..., slot }, counts
+		lua_pushnumber(L, B.mLaps[i]);	// B, how, slots_out, counts_out, slots, counts, count
+		lua_rawseti(L, 6, int(i + 1));	// B, how, slots_out, counts_out, slots, counts = { ..., count }
+	}
+
+	lua_pushinteger(L, lua_Integer(B.mFired.size()));	// B, how, slots_out, counts_out, slots, counts, n
+
+	return 3;
+}
+
+/// Checks one timer for timeouts
+/// @remark Arguments: slot, how
+/// @return Timeout count
+static int CheckSlot (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	lua_pushnumber(L, B.Check(Slot(L, B, 2), How(L, 3)));	// B, slot, how, count
+
+	return 1;
+}
+
+/// Stops a timer and releases its slot
+/// @remark Arguments: slot
+/// @remark A slot outside the bank is ignored: a timer's finalizer may run after its bank's,
+/// which leaves the bank empty
+/// @remark A slot that is already free is also ignored, so that a double free cannot put it
+/// on the free list twice and hand it to two timers
+/// @return If @b true, the slot was released
+static int Free (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	int slot = sI(L, 2) - 1;
+
+	lua_pushboolean(L, slot >= 0 && size_t(slot) < B.mDuration.size() && B.Free(size_t(slot)));	// B, slot, freed
+
+	return 1;
+}
+
+/// Gets a timer's counter, as per Timer:GetCounter
+/// @remark Arguments: slot[, is_fraction]
+/// @return Counter, or 0 if the timer is stopped
+static int GetCounter (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	double counter = 0.0;
+
+	if (B.mDuration[slot] > 0.0) counter = lua_toboolean(L, 3) ? B.mCounter[slot] / B.mDuration[slot] : B.mCounter[slot];
+
+	lua_pushnumber(L, counter);	// B, slot[, is_fraction], counter
+
+	return 1;
+}
+
+/// Gets a timer's duration
+/// @remark Arguments: slot
+/// @return Duration, or @b nil if stopped
+static int GetDuration (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	if (B.mDuration[slot] > 0.0) lua_pushnumber(L, B.mDuration[slot]);	// B, slot, duration
+
+	else lua_pushnil(L);// B, slot, nil
+
+	return 1;
+}
+
+/// Gets a timer's state
+/// @remark Arguments: slot
+/// @return Duration, or @b nil if stopped; counter; offset; and pause state
+static int Get (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	if (B.mDuration[slot] > 0.0) lua_pushnumber(L, B.mDuration[slot]);	// B, slot, duration
+
+	else lua_pushnil(L);// B, slot, nil
+
+	lua_pushnumber(L, B.mCounter[slot]);// B, slot, duration, counter
+	lua_pushnumber(L, B.mOffset[slot]);	// B, slot, duration, counter, offset
+	lua_pushboolean(L, B.mPaused[slot]);// B, slot, duration, counter, offset, bPaused
+
+	return 4;
+}
+
+/// Sets a timer's state
+/// @remark Arguments: slot, duration, counter, offset, bPaused
+/// @remark A @b nil duration stops the timer
+static int Set (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	B.mDuration[slot] = lua_isnil(L, 3) ? 0.0 : D(L, 3);
+	B.mCounter[slot] = D(L, 4);
+	B.mOffset[slot] = D(L, 5);
+	B.mPaused[slot] = lua_toboolean(L, 6) != 0;
+
+	B.SetRate(slot);
+
+	return 0;
+}
+
+/// Sets a timer's counter, as per Timer:SetCounter
+/// @remark Arguments: slot, counter[, is_fraction]
+/// @return If true, the counter was set; if false, the timer was stopped
+static int SetCounter (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	double duration = B.mDuration[slot], counter = D(L, 3);
+
+	if (duration > 0.0)
+	{
+		if (lua_toboolean(L, 4)) counter *= duration;
+
+		B.mCounter[slot] = counter;
+		B.mOffset[slot] = counter - std::floor(counter / duration) * duration;
+	}
+
+	lua_pushboolean(L, duration > 0.0);	// B, slot, counter[, is_fraction], bSet
+
+	return 1;
+}
+
+/// Pauses or resumes a timer
+/// @remark Arguments: slot, pause
+static int SetPause (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	B.mPaused[slot] = lua_toboolean(L, 3) != 0;
+
+	B.SetRate(slot);
+
+	return 0;
+}
+
+/// Starts a timer
+/// @remark Arguments: slot, duration, t
+static int Start (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+	double duration = D(L, 3);
+
+	luaL_argcheck(L, duration > 0.0, 3, "Non-positive duration");
+
+	B.Start(slot, duration, D(L, 4));
+
+	return 0;
+}
+
+/// Stops a timer, keeping its slot
+/// @remark Arguments: slot
+static int Stop (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	B.mDuration[slot] = 0.0;
+
+	B.SetRate(slot);
+
+	return 0;
+}
+
+/// Advances every running, unpaused timer in the bank
+/// @remark Arguments: step
+static int Update (lua_State * L)
+{
+	luaT_ref<TimerBank>(L, 1).Update(D(L, 2));
+
+	return 0;
+}
+
+/// Advances one timer, as per Timer:Update
+/// @remark Arguments: slot, step
+static int UpdateSlot (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	size_t slot = Slot(L, B, 2);
+
+	B.mCounter[slot] += D(L, 3) * B.mRate[slot];
+
+	return 0;
+}
+
+/// Metamethod
+/// @return Count of slots in use
+static int Len (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	lua_pushinteger(L, lua_Integer(B.mDuration.size() - B.mFree.size()));	// B, count
+
+	return 1;
+}
+
+/// Constructor
+static int Cons (lua_State * L)
+{
+	new (UD(L, 1)) TimerBank;
+
+	return 0;
+}
+
+/// Metamethod
+/// @remark The bank is left empty rather than destroyed outright, since the finalizers of
+/// its timers may still free their slots afterward
+static int GC (lua_State * L)
+{
+	TimerBank & B = luaT_ref<TimerBank>(L, 1);
+
+	B.~TimerBank();
+
+	new (&B) TimerBank;
+
+	return 0;
+}
+
+/// Binds the TimerBank class
+int Bindings::open_timerbank (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Alloc", Alloc },
+		{ "Check", Check },
+		{ "CheckSlot", CheckSlot },
+		{ "Free", Free },
+		{ "Get", Get },
+		{ "GetCounter", GetCounter },
+		{ "GetDuration", GetDuration },
+		{ "Set", Set },
+		{ "SetCounter", SetCounter },
+		{ "SetPause", SetPause },
+		{ "Start", Start },
+		{ "Stop", Stop },
+		{ "Update", Update },
+		{ "UpdateSlot", UpdateSlot },
+		{ "__cons", Cons },
+		{ "__gc", GC },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "TimerBank", methods, Class::Def(sizeof(TimerBank)));
+
+	return 0;
+}
\ No newline at end of file
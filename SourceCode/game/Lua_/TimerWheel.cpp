@@ -0,0 +1,186 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Lua;
+
+/// Hashed timer wheel over absolute times
+/// @remark Entries are never consumed by a query, so a client may move its cursor backward
+/// or forward at will; each query visits only the buckets spanned by its time range
+struct TimerWheel {
+	/// Scheduled entry
+	struct Entry {
+		double mWhen;	///< Entry time
+		int mID;///< Client-side ID
+
+		/// @return If @b true, this entry comes before @e other
+		bool operator < (const Entry & other) const
+		{
+			return mWhen < other.mWhen || (mWhen == other.mWhen && mID < other.mID);
+		}
+	};
+
+	std::vector<std::vector<Entry> > mBuckets;	///< Buckets, indexed by time slice modulo bucket count
+	std::vector<Entry> mDue;///< Scratch array of due entries
+	double mGranularity;///< Time slice covered by one bucket
+	size_t mCount;	///< Count of entries
+
+	TimerWheel (double granularity, size_t buckets) : mBuckets(buckets), mGranularity(granularity), mCount(0) {}
+
+	/// @return Absolute time slice of a time
+	double Slice (double when) const
+	{
+		return std::floor(when / mGranularity);
+	}
+
+	/// @return Bucket index of a time slice
+	size_t Bucket (double slice) const
+	{
+		double index = std::fmod(slice, double(mBuckets.size()));
+
+		return size_t(index < 0.0 ? index + double(mBuckets.size()) : index);
+	}
+
+	/// Adds an entry
+	void Add (double when, int id)
+	{
+		Entry entry = { when, id };
+
+		mBuckets[Bucket(Slice(when))].push_back(entry);
+
+		++mCount;
+	}
+
+	/// Collects the entries in a half-open time range, in order
+	/// @param from Range start, inclusive
+	/// @param to Range end, exclusive
+	void Gather (double from, double to)
+	{
+		mDue.clear();
+
+		if (!(from < to)) return;
+
+		// Visit the buckets under the range. If the range wraps the wheel, each bucket
+		// is visited once; otherwise, only the slices in range are visited.
+		double first = Slice(from), span = Slice(to) - first + 1.0;
+		size_t count = span < double(mBuckets.size()) ? size_t(span) : mBuckets.size();
+		size_t bucket = count < mBuckets.size() ? Bucket(first) : 0;
+
+		for (size_t i = 0; i < count; ++i, bucket = (bucket + 1) % mBuckets.size())
+		{
+			const std::vector<Entry> & entries = mBuckets[bucket];
+
+			for (size_t j = 0; j < entries.size(); ++j)
+			{
+				if (entries[j].mWhen >= from && entries[j].mWhen < to) mDue.push_back(entries[j]);
+			}
+		}
+
+		std::sort(mDue.begin(), mDue.end());
+	}
+
+	/// Removes all entries
+	void Clear (void)
+	{
+		for (size_t i = 0; i < mBuckets.size(); ++i) mBuckets[i].clear();
+
+		mCount = 0;
+	}
+};
+
+namespace Lua
+{
+	/// TimerWheel type name
+	template<> const char * luaT_type<TimerWheel> (void) { return "TimerWheel"; }
+}
+
+/// Schedules an entry
+/// @remark Arguments: when, id
+static int Add (lua_State * L)
+{
+	luaT_ref<TimerWheel>(L, 1).Add(D(L, 2), sI(L, 3));
+
+	return 0;
+}
+
+/// Removes all entries
+static int Clear (lua_State * L)
+{
+	luaT_ref<TimerWheel>(L, 1).Clear();
+
+	return 0;
+}
+
+/// Gets the entries falling within a time range
+/// @remark Arguments: from, to[, out]
+/// @return Table of IDs, ordered by time and then by ID; range includes @e from, but not @e to
+/// @return Count of IDs
+static int Gather (lua_State * L)
+{
+	lua_settop(L, 4);
+
+	TimerWheel & W = luaT_ref<TimerWheel>(L, 1);
+
+	W.Gather(D(L, 2), D(L, 3));
+
+	PrepOutTable(L, 4, int(W.mDue.size()));	// W, from, to, out, out
+
+	for (size_t i = 0; i < W.mDue.size(); ++i)
+	{
+		lua_pushinteger(L, W.mDue[i].mID);	// W, from, to, out, out, id
+		lua_rawseti(L, -2, int(i + 1));	// W, from, to, out, out = { ..., id }
+	}
+
+	lua_pushinteger(L, lua_Integer(W.mDue.size()));	// W, from, to, out, out, count
+
+	return 2;
+}
+
+/// Metamethod
+/// @return Count of entries
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(luaT_ref<TimerWheel>(L, 1).mCount));	// W, count
+
+	return 1;
+}
+
+/// Constructor
+/// @remark Arguments: granularity[, buckets]
+static int Cons (lua_State * L)
+{
+	double granularity = D(L, 2);
+	int buckets = luaL_optint(L, 3, 256);
+
+	luaL_argcheck(L, granularity > 0.0, 2, "Non-positive granularity");
+	luaL_argcheck(L, buckets > 0, 3, "Non-positive bucket count");
+
+	new (UD(L, 1)) TimerWheel(granularity, size_t(buckets));
+
+	return 0;
+}
+
+/// Binds the TimerWheel class
+int Bindings::open_timerwheel (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Add", Add },
+		{ "Clear", Clear },
+		{ "Gather", Gather },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<TimerWheel> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "TimerWheel", methods, Class::Def(sizeof(TimerWheel)));
+
+	return 0;
+}
\ No newline at end of file
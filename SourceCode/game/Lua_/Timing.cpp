@@ -0,0 +1,56 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+using namespace Lua;
+
+/// @return Monotonic time, in microseconds
+static double Now (void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER sFrequency;
+
+	if (0 == sFrequency.QuadPart) QueryPerformanceFrequency(&sFrequency);
+
+	LARGE_INTEGER count;
+
+	QueryPerformanceCounter(&count);
+
+	return double(count.QuadPart) * 1e6 / double(sFrequency.QuadPart);
+#else
+	timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return double(ts.tv_sec) * 1e6 + double(ts.tv_nsec) / 1e3;
+#endif
+}
+
+/// @return Monotonic time, in microseconds, from the high-resolution clock
+static int Microseconds (lua_State * L)
+{
+	lua_pushnumber(L, Now());	// us
+
+	return 1;
+}
+
+/// Registers the timing library
+int Bindings::open_timing (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "Microseconds", Microseconds },
+		{ 0, 0 }
+	};
+
+	Register(L, "timing", funcs);
+
+	return 0;
+}
\ No newline at end of file
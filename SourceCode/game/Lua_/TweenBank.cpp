@@ -0,0 +1,425 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <cmath>
+#include <vector>
+#include <xmmintrin.h>
+
+using namespace Lua;
+
+/// Structure-of-arrays storage for tweens, each driving one setter on one target
+/// @remark Arrays are padded with idle slots to a multiple of the SIMD width
+/// @remark Targets, setter names, and custom maps live in a table in the bank's environment
+struct TweenBank {
+	enum { eWidth = 4 };///< SIMD lane count
+
+	/// Interpolation modes, as per Interpolator
+	enum Mode { eOnce, eOscillate, eOscillateOnce };
+
+	/// Easing curves
+	enum Ease { eLinear, eQuad, eCubic, eSine, eElastic, eCustom };
+
+	std::vector<float> mElapsed;///< Time elapsed since tween began
+	std::vector<float> mDuration;	///< Time to run from t = 0 to t = 1
+	std::vector<float> mPhase;	///< Elapsed time, in durations
+	std::vector<float> mRate;	///< 1 if live, else 0
+	std::vector<float> mFrom;	///< Value at t = 0
+	std::vector<float> mDelta;	///< Change in value from t = 0 to t = 1
+	std::vector<unsigned char> mMode;	///< Interpolation mode
+	std::vector<unsigned char> mEase;	///< Easing curve
+	std::vector<int> mGenerations;	///< Generation of each slot, bumped on release
+	std::vector<int> mFree;	///< Free slots
+	size_t mLive;	///< Count of live tweens
+
+	TweenBank (void) : mLive(0) {}
+
+	/// Claims a slot
+	/// @return Slot index
+	size_t Alloc (void)
+	{
+		if (mFree.empty())
+		{
+			size_t size = mElapsed.size();
+
+			mElapsed.resize(size + eWidth, 0.0f);
+			mDuration.resize(size + eWidth, 1.0f);
+			mPhase.resize(size + eWidth, 0.0f);
+			mRate.resize(size + eWidth, 0.0f);
+			mFrom.resize(size + eWidth, 0.0f);
+			mDelta.resize(size + eWidth, 0.0f);
+			mMode.resize(size + eWidth, eOnce);
+			mEase.resize(size + eWidth, eLinear);
+			mGenerations.resize(size + eWidth, 0);
+
+			for (size_t i = size + eWidth; i > size; --i) mFree.push_back(int(i - 1));
+		}
+
+		size_t slot = size_t(mFree.back());
+
+		mFree.pop_back();
+
+		++mLive;
+
+		return slot;
+	}
+
+	/// Idles a slot and returns it to the free list
+	void Free (size_t slot)
+	{
+		mElapsed[slot] = mPhase[slot] = mRate[slot] = 0.0f;
+		mDuration[slot] = 1.0f;
+
+		++mGenerations[slot];
+
+		mFree.push_back(int(slot));
+
+		--mLive;
+	}
+
+	/// @return ID for a slot, in its current generation
+	/// @remark Slots are shared by many clients over time, so an ID goes stale once its
+	/// tween is released, rather than referring to whatever tween reuses the slot
+	double IDOf (size_t slot) const
+	{
+		return double(mGenerations[slot]) * 16777216.0 + double(slot + 1);
+	}
+
+	/// @return Slot for an ID, or -1 if the ID is stale or invalid
+	int SlotOf (double id) const
+	{
+		double gen = std::floor(id / 16777216.0);
+		int slot = int(id - gen * 16777216.0) - 1;
+
+		if (slot < 0 || size_t(slot) >= mRate.size() || mRate[slot] == 0.0f || mGenerations[slot] != int(gen)) return -1;
+
+		return slot;
+	}
+
+	/// Advances every live tween, finding its phase
+	/// @param step Time step
+	void Advance (float step)
+	{
+		__m128 vStep = _mm_set1_ps(step);
+
+		for (size_t i = 0; i < mElapsed.size(); i += eWidth)
+		{
+			__m128 elapsed = _mm_add_ps(_mm_loadu_ps(&mElapsed[i]), _mm_mul_ps(vStep, _mm_loadu_ps(&mRate[i])));
+
+			_mm_storeu_ps(&mElapsed[i], elapsed);
+			_mm_storeu_ps(&mPhase[i], _mm_div_ps(elapsed, _mm_loadu_ps(&mDuration[i])));
+		}
+	}
+
+	/// Folds a slot's phase into a time, according to its mode
+	/// @param slot Slot index
+	/// @param t [out] Time, in [0, 1]
+	/// @param bDecreasing [out] If @b true, the time is decreasing
+	/// @return If @b true, the tween is done
+	bool Time (size_t slot, float & t, bool & bDecreasing) const
+	{
+		float phase = mPhase[slot];
+
+		bDecreasing = false;
+
+		switch (mMode[slot])
+		{
+		case eOnce:
+			t = phase < 1.0f ? phase : 1.0f;
+
+			return phase >= 1.0f;
+		case eOscillateOnce:
+			if (phase >= 2.0f) phase = 2.0f;
+
+			bDecreasing = phase > 1.0f;
+
+			t = bDecreasing ? 2.0f - phase : phase;
+
+			return phase >= 2.0f;
+		default:
+			{
+				float lap = std::floor(phase);
+
+				bDecreasing = std::fmod(lap, 2.0f) != 0.0f;
+
+				t = phase - lap;
+
+				if (bDecreasing) t = 1.0f - t;
+			}
+
+			return false;
+		}
+	}
+
+	/// Applies a built-in easing curve
+	/// @param ease Curve
+	/// @param t Time, in [0, 1]
+	/// @return Eased time
+	static float Eased (int ease, float t)
+	{
+		float u = 1.0f - t;
+
+		switch (ease)
+		{
+		case eQuad:
+			return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * u * u;
+		case eCubic:
+			return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * u * u * u;
+		case eSine:
+			return 0.5f - 0.5f * std::cos(t * 3.14159265f);
+		case eElastic:
+			if (t <= 0.0f || t >= 1.0f) return t;
+
+			return std::pow(2.0f, -10.0f * t) * std::sin((t * 10.0f - 0.75f) * (2.0f * 3.14159265f / 3.0f)) + 1.0f;
+		default:
+			return t;
+		}
+	}
+};
+
+namespace Lua
+{
+	/// TweenBank type name
+	template<> const char * luaT_type<TweenBank> (void) { return "TweenBank"; }
+}
+
+/// Dummy variable; the reference table is stored in the environment under its address
+static int _refs;
+
+/// Reference table layout: target, setter name, and custom map, per slot
+enum { eTarget = 1, eSetter, eMap, eRefCount = eMap };
+
+/// @return Bank at index 1
+/// @remark Reference table left on stack
+static TweenBank & Bank (lua_State * L)
+{
+	TweenBank & B = luaT_ref<TweenBank>(L, 1);
+
+	lua_getfenv(L, 1);	// B, ..., env
+	lua_pushlightuserdata(L, &_refs);	// B, ..., env, key
+	lua_rawget(L, -2);	// B, ..., env, refs
+	lua_replace(L, -2);	// B, ..., refs
+
+	return B;
+}
+
+/// Stores or clears one of a slot's references
+/// @param refs Stack index of reference table
+/// @param slot Slot index
+/// @param what Reference type
+/// @param value Stack index of value, or 0 to clear it
+static void SetRef (lua_State * L, int refs, size_t slot, int what, int value)
+{
+	value != 0 ? lua_pushvalue(L, value) : lua_pushnil(L);	// ..., value_or_nil
+
+	lua_rawseti(L, refs, int(slot) * eRefCount + what);	// ...
+}
+
+/// Releases a slot and its references
+static void Release (lua_State * L, TweenBank & B, int refs, size_t slot)
+{
+	for (int i = eTarget; i <= eRefCount; ++i) SetRef(L, refs, slot, i, 0);
+
+	B.Free(slot);
+}
+
+/// Validates a tween ID
+/// @param index Stack index of ID, as returned by Add()
+/// @return Slot index, or -1 if the tween is not live
+static int Slot (lua_State * L, TweenBank & B, int index)
+{
+	return B.SlotOf(D(L, index));
+}
+
+/// Adds a tween, which drives <i><b>target:setter(value)</b></i>
+/// @remark Arguments: target, setter, from, to, duration[, mode[, ease]]
+/// @remark @e mode is as per Interpolator:Start; @e ease is one of @b "linear" (the default),
+/// @b "quad", @b "cubic", @b "sine", @b "elastic", or a map function as per Interpolator:SetMap
+/// @return Tween ID
+static int Add (lua_State * L)
+{
+	lua_settop(L, 8);
+	luaL_checkstring(L, 3);
+
+	const char * modes[] = { "once", "oscillate", "oscillate_once", 0 };
+	const char * eases[] = { "linear", "quad", "cubic", "sine", "elastic", 0 };
+
+	float from = F(L, 4), to = F(L, 5), duration = F(L, 6);
+	int mode = luaL_checkoption(L, 7, "once", modes);
+	int ease = lua_isfunction(L, 8) ? TweenBank::eCustom : luaL_checkoption(L, 8, "linear", eases);
+
+	luaL_argcheck(L, duration > 0.0f, 6, "Non-positive duration");
+
+	TweenBank & B = Bank(L);// B, target, setter, from, to, duration, mode, ease, refs
+
+	size_t slot = B.Alloc();
+
+	B.mDuration[slot] = duration;
+	B.mRate[slot] = 1.0f;
+	B.mFrom[slot] = from;
+	B.mDelta[slot] = to - from;
+	B.mMode[slot] = (unsigned char)mode;
+	B.mEase[slot] = (unsigned char)ease;
+
+	SetRef(L, 9, slot, eTarget, 2);
+	SetRef(L, 9, slot, eSetter, 3);
+	SetRef(L, 9, slot, eMap, ease == TweenBank::eCustom ? 8 : 0);
+
+	lua_pushnumber(L, B.IDOf(slot));// B, target, setter, from, to, duration, mode, ease, refs, id
+
+	return 1;
+}
+
+/// Removes every tween
+static int Clear (lua_State * L)
+{
+	lua_settop(L, 1);
+
+	TweenBank & B = Bank(L);// B, refs
+
+	for (size_t i = 0; i < B.mRate.size(); ++i)
+	{
+		if (B.mRate[i] != 0.0f) Release(L, B, 2, i);
+	}
+
+	return 0;
+}
+
+/// @remark Arguments: id
+/// @return If @b true, the tween is still running
+static int IsActive (lua_State * L)
+{
+	TweenBank & B = luaT_ref<TweenBank>(L, 1);
+
+	lua_pushboolean(L, Slot(L, B, 2) >= 0);	// B, id, bActive
+
+	return 1;
+}
+
+/// Removes a tween, leaving its target as it is
+/// @remark Arguments: id
+static int Remove (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	TweenBank & B = Bank(L);// B, id, refs
+
+	int slot = Slot(L, B, 2);
+
+	if (slot >= 0) Release(L, B, 3, size_t(slot));
+
+	return 0;
+}
+
+/// Moves a tween ahead in time, e.g. to make up time its owner missed
+/// @remark Arguments: id, step
+/// @remark The target is sent its value on the next update
+static int Skip (lua_State * L)
+{
+	TweenBank & B = luaT_ref<TweenBank>(L, 1);
+
+	int slot = Slot(L, B, 2);
+
+	if (slot >= 0) B.mElapsed[slot] += F(L, 3);
+
+	return 0;
+}
+
+/// Advances every tween, and sends each target its new value
+/// @remark Arguments: step
+/// @return Count of tweens still running
+/// @remark Tweens that finish are sent their final value, then removed
+static int Update (lua_State * L)
+{
+	lua_settop(L, 2);
+
+	TweenBank & B = Bank(L);// B, step, refs
+
+	B.Advance(F(L, 2));
+
+	for (size_t i = 0; i < B.mRate.size(); ++i)
+	{
+		if (B.mRate[i] == 0.0f) continue;
+
+		float t;
+		bool bDecreasing, bDone = B.Time(i, t, bDecreasing);
+		int gen = B.mGenerations[i];
+
+		// Ease the time, calling out to Lua only for custom maps.
+		if (TweenBank::eCustom == B.mEase[i])
+		{
+			lua_rawgeti(L, 3, int(i) * eRefCount + eMap);	// B, step, refs, map
+			lua_pushnumber(L, t);	// B, step, refs, map, t
+			lua_pushboolean(L, bDecreasing);// B, step, refs, map, t, bDecreasing
+			lua_call(L, 2, 1);	// B, step, refs, mapped
+
+			t = F(L, 4);
+
+			lua_pop(L, 1);	// B, step, refs
+		}
+
+		else t = TweenBank::Eased(B.mEase[i], t);
+
+		// Send the target its value.
+		lua_rawgeti(L, 3, int(i) * eRefCount + eTarget);// B, step, refs, target
+		lua_rawgeti(L, 3, int(i) * eRefCount + eSetter);// B, step, refs, target, setter
+		lua_gettable(L, 4);	// B, step, refs, target, method
+		lua_insert(L, 4);	// B, step, refs, method, target
+		lua_pushnumber(L, B.mFrom[i] + B.mDelta[i] * t);// B, step, refs, method, target, value
+		lua_call(L, 2, 0);	// B, step, refs
+
+		// Retire finished tweens, unless the setter already removed them (and perhaps added
+		// another tween in the slot).
+		if (bDone && B.mGenerations[i] == gen) Release(L, B, 3, i);
+	}
+
+	lua_pushinteger(L, lua_Integer(B.mLive));	// B, step, refs, count
+
+	return 1;
+}
+
+/// Metamethod
+/// @return Count of tweens still running
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(luaT_ref<TweenBank>(L, 1).mLive));	// B, count
+
+	return 1;
+}
+
+/// Constructor
+static int Cons (lua_State * L)
+{
+	new (UD(L, 1)) TweenBank;
+
+	lua_getfenv(L, 1);	// B, ..., env
+	lua_pushlightuserdata(L, &_refs);	// B, ..., env, key
+	lua_newtable(L);// B, ..., env, key, {}
+	lua_rawset(L, -3);	// B, ..., env = { [key] = {} }
+
+	return 0;
+}
+
+/// Binds the TweenBank class
+int Bindings::open_tweenbank (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Add", Add },
+		{ "Clear", Clear },
+		{ "IsActive", IsActive },
+		{ "Remove", Remove },
+		{ "Skip", Skip },
+		{ "Update", Update },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<TweenBank> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "TweenBank", methods, Class::Def(sizeof(TweenBank)));
+
+	return 0;
+}
\ No newline at end of file
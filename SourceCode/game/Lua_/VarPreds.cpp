@@ -0,0 +1,265 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include <cmath>
+
+using namespace Lua;
+
+/// Native versions of the var_preds type and number predicates
+/// @remark Each predicate tests its first argument and returns a boolean, with the same
+/// semantics as the script version; in particular, the predicates without a "_Number"
+/// suffix accept strings convertible to numbers
+enum { eNegative, eNonNegative, eNonPositive, ePositive };
+
+/// @return If true, a number is integral; false for infinities and NaNs, as with n % 1 == 0
+static bool IsIntegral (lua_Number n)
+{
+	return n - floor(n) == 0;
+}
+
+/// @return Type of a value, as reported by type(), so light userdata count as userdata
+static int Type (lua_State * L, int index)
+{
+	int vtype = lua_type(L, index);
+
+	return LUA_TLIGHTUSERDATA == vtype ? LUA_TUSERDATA : vtype;
+}
+
+/// @return If true, a value's metatable has the given field, even if false
+static bool HasMetaField (lua_State * L, int index, const char * name)
+{
+	if (!lua_getmetatable(L, index)) return false;	// ...[, mt]
+
+	lua_pushstring(L, name);// ..., mt, name
+	lua_rawget(L, -2);	// ..., mt, field
+
+	bool bHas = !lua_isnil(L, -1);
+
+	lua_pop(L, 2);	// ...
+
+	return bHas;
+}
+
+/// Tests the sign, and optionally integrality, of a number
+template<int how, bool bStrict, bool bInteger> static int SignPred (lua_State * L)
+{
+	bool bPass = bStrict ? lua_type(L, 1) == LUA_TNUMBER : lua_isnumber(L, 1) != 0;
+
+	if (bPass)
+	{
+		lua_Number n = lua_tonumber(L, 1);
+
+		switch (how)
+		{
+		case eNegative:
+			bPass = n < 0;
+			break;
+		case eNonNegative:
+			bPass = n >= 0;
+			break;
+		case eNonPositive:
+			bPass = n <= 0;
+			break;
+		default:
+			bPass = n > 0;
+		}
+
+		if (bInteger) bPass = bPass && IsIntegral(n);
+	}
+
+	lua_pushboolean(L, bPass);	// ..., pass
+
+	return 1;
+}
+
+/// Tests a value's type, and optionally allows nil
+template<int type, bool bOrNil> static int TypePred (lua_State * L)
+{
+	int vtype = Type(L, 1);
+
+	lua_pushboolean(L, vtype == type || (bOrNil && vtype <= LUA_TNIL));	// ..., pass
+
+	return 1;
+}
+
+/// Tests whether a value has either of two types, and optionally allows nil
+template<int type1, int type2, bool bOrNil> static int TypeChoicePred (lua_State * L)
+{
+	int vtype = Type(L, 1);
+
+	lua_pushboolean(L, vtype == type1 || vtype == type2 || (bOrNil && vtype <= LUA_TNIL));// ..., pass
+
+	return 1;
+}
+
+/// Tests whether a value is callable, and optionally allows nil
+template<bool bOrNil> static int CallablePred (lua_State * L)
+{
+	int vtype = lua_type(L, 1);
+
+	lua_pushboolean(L, vtype == LUA_TFUNCTION || (bOrNil && vtype <= LUA_TNIL) || HasMetaField(L, 1, "__call"));	// ..., pass
+
+	return 1;
+}
+
+/// @remark Arguments: var, meta
+/// @return If true, the value's metatable has the metaproperty
+static int HasMeta (lua_State * L)
+{
+	bool bHas = false;
+
+	if (lua_getmetatable(L, 1))	// var, meta, mt
+	{
+		lua_pushvalue(L, 2);// var, meta, mt, meta
+		lua_rawget(L, -2);	// var, meta, mt, field
+
+		bHas = !lua_isnil(L, -1);
+	}
+
+	lua_pushboolean(L, bHas);	// ..., has
+
+	return 1;
+}
+
+/// @return If true, the value is countable
+static int IsCountable (lua_State * L)
+{
+	int vtype = lua_type(L, 1);
+
+	lua_pushboolean(L, vtype == LUA_TSTRING || vtype == LUA_TTABLE || HasMetaField(L, 1, "__len"));// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is read- and write-indexable
+/// @remark As in script, a false __index counts as present
+static int IsIndexable (lua_State * L)
+{
+	bool bPass = lua_istable(L, 1);
+
+	if (!bPass && lua_getmetatable(L, 1))	// var, mt
+	{
+		lua_pushliteral(L, "__index");	// var, mt, "__index"
+		lua_rawget(L, -2);	// var, mt, index
+
+		if (lua_isboolean(L, -1) && !lua_toboolean(L, -1)) bPass = true;
+
+		else if (!lua_isnil(L, -1)) bPass = HasMetaField(L, 1, "__newindex");
+	}
+
+	lua_pushboolean(L, bPass);	// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is read-indexable
+static int IsIndexableR (lua_State * L)
+{
+	lua_pushboolean(L, lua_istable(L, 1) || HasMetaField(L, 1, "__index"));	// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is write-indexable
+static int IsIndexableW (lua_State * L)
+{
+	lua_pushboolean(L, lua_istable(L, 1) || HasMetaField(L, 1, "__newindex"));	// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is an integer, or a string convertible to one
+static int IsInteger (lua_State * L)
+{
+	lua_pushboolean(L, lua_isnumber(L, 1) && IsIntegral(lua_tonumber(L, 1)));	// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is an integer
+static int IsInteger_Number (lua_State * L)
+{
+	lua_pushboolean(L, lua_type(L, 1) == LUA_TNUMBER && IsIntegral(lua_tonumber(L, 1)));// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is NaN
+static int IsNaN (lua_State * L)
+{
+	lua_Number n = lua_tonumber(L, 1);
+
+	lua_pushboolean(L, lua_type(L, 1) == LUA_TNUMBER && n != n);// ..., pass
+
+	return 1;
+}
+
+/// @return If true, the value is nil
+static int IsNil (lua_State * L)
+{
+	lua_pushboolean(L, lua_isnoneornil(L, 1));	// ..., pass
+
+	return 1;
+}
+
+/// Registers the var_preds_native library
+/// @remark Binding this is optional; if present, var_preds uses it for its predicates
+/// unless told otherwise at boot
+int Bindings::open_varpreds (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "HasMeta", HasMeta },
+		{ "IsBoolean", TypePred<LUA_TBOOLEAN, false> },
+		{ "IsBooleanOrNil", TypePred<LUA_TBOOLEAN, true> },
+		{ "IsCallable", CallablePred<false> },
+		{ "IsCallableOrNil", CallablePred<true> },
+		{ "IsCountable", IsCountable },
+		{ "IsFunction", TypePred<LUA_TFUNCTION, false> },
+		{ "IsFunctionOrNil", TypePred<LUA_TFUNCTION, true> },
+		{ "IsFunctionOrTable", TypeChoicePred<LUA_TFUNCTION, LUA_TTABLE, false> },
+		{ "IsFunctionOrTableOrNil", TypeChoicePred<LUA_TFUNCTION, LUA_TTABLE, true> },
+		{ "IsIndexable", IsIndexable },
+		{ "IsIndexableR", IsIndexableR },
+		{ "IsIndexableW", IsIndexableW },
+		{ "IsInteger", IsInteger },
+		{ "IsInteger_Number", IsInteger_Number },
+		{ "IsNaN", IsNaN },
+		{ "IsNegative", SignPred<eNegative, false, false> },
+		{ "IsNegative_Number", SignPred<eNegative, true, false> },
+		{ "IsNegativeInteger", SignPred<eNegative, false, true> },
+		{ "IsNegativeInteger_Number", SignPred<eNegative, true, true> },
+		{ "IsNil", IsNil },
+		{ "IsNonNegative", SignPred<eNonNegative, false, false> },
+		{ "IsNonNegative_Number", SignPred<eNonNegative, true, false> },
+		{ "IsNonNegativeInteger", SignPred<eNonNegative, false, true> },
+		{ "IsNonNegativeInteger_Number", SignPred<eNonNegative, true, true> },
+		{ "IsNonPositive", SignPred<eNonPositive, false, false> },
+		{ "IsNonPositive_Number", SignPred<eNonPositive, true, false> },
+		{ "IsNonPositiveInteger", SignPred<eNonPositive, false, true> },
+		{ "IsNonPositiveInteger_Number", SignPred<eNonPositive, true, true> },
+		{ "IsNumber", TypePred<LUA_TNUMBER, false> },
+		{ "IsNumberOrNil", TypePred<LUA_TNUMBER, true> },
+		{ "IsPositive", SignPred<ePositive, false, false> },
+		{ "IsPositive_Number", SignPred<ePositive, true, false> },
+		{ "IsPositiveInteger", SignPred<ePositive, false, true> },
+		{ "IsPositiveInteger_Number", SignPred<ePositive, true, true> },
+		{ "IsString", TypePred<LUA_TSTRING, false> },
+		{ "IsStringOrNil", TypePred<LUA_TSTRING, true> },
+		{ "IsTable", TypePred<LUA_TTABLE, false> },
+		{ "IsTableOrNil", TypePred<LUA_TTABLE, true> },
+		{ "IsTableOrUserdata", TypeChoicePred<LUA_TTABLE, LUA_TUSERDATA, false> },
+		{ "IsTableOrUserdataOrNil", TypeChoicePred<LUA_TTABLE, LUA_TUSERDATA, true> },
+		{ "IsThread", TypePred<LUA_TTHREAD, false> },
+		{ "IsThreadOrNil", TypePred<LUA_TTHREAD, true> },
+		{ "IsUserdata", TypePred<LUA_TUSERDATA, false> },
+		{ "IsUserdataOrNil", TypePred<LUA_TUSERDATA, true> },
+		{ 0, 0 }
+	};
+
+	Register(L, "var_preds_native", funcs);
+
+	return 0;
+}
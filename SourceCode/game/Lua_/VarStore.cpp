@@ -0,0 +1,526 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include <vector>
+
+using namespace Lua;
+
+/// Typed storage for one tier of bool or number variables, indexed by interned ID
+/// @remark Variable names are interned once, globally, to dense integer IDs. Bools then
+/// live in a bitset and numbers in a dense array; unset variables read as false or 0.
+/// @remark Stores are plain userdata, so their metamethods serve variable lookups directly,
+/// by ID or by name. Numbers are always taken as IDs, so they cannot be names.
+/// @remark Watched variables are put on a dirty list when written, or when a copy changes
+/// them, to be taken in a batch
+struct VarStore {
+	enum { eBits = 32 };///< Bits per word
+
+	std::vector<unsigned> mSet;	///< Bit per ID: variable has a value
+	std::vector<unsigned> mBools;	///< Bit per ID: bool value (bool stores only)
+	std::vector<double> mNumbers;	///< Value per ID (number stores only)
+	std::vector<unsigned> mWatched;	///< Bit per ID: variable is watched
+	std::vector<unsigned> mIsDirty;	///< Bit per ID: variable is on the dirty list
+	std::vector<int> mDirty;///< IDs of watched variables written since the last take
+	bool mIsBools;	///< If true, the store holds bools; otherwise numbers
+
+	VarStore (bool bIsBools) : mIsBools(bIsBools)
+	{
+	}
+
+	/// @return If true, the bit for an ID is set in a bitset
+	static bool Test (const std::vector<unsigned> & bits, int id)
+	{
+		size_t word = size_t(id) / eBits;
+
+		return word < bits.size() && (bits[word] & (1u << (id % eBits))) != 0;
+	}
+
+	/// Sets or clears the bit for an ID in a bitset
+	static void Flag (std::vector<unsigned> & bits, int id, bool bOn)
+	{
+		size_t word = size_t(id) / eBits;
+
+		if (word >= bits.size()) bits.resize(word + 1, 0);
+
+		if (bOn) bits[word] |= 1u << (id % eBits);
+
+		else bits[word] &= ~(1u << (id % eBits));
+	}
+
+	/// Puts a variable on the dirty list, if watched and not already there
+	void Mark (int id)
+	{
+		if (Test(mWatched, id) && !Test(mIsDirty, id))
+		{
+			Flag(mIsDirty, id, true);
+
+			mDirty.push_back(id);
+		}
+	}
+
+	/// @return If true, the variable differs from its value in another store
+	bool Differs (const VarStore & other, int id) const
+	{
+		if (IsSet(id) != other.IsSet(id)) return true;
+
+		return mIsBools ? GetBool(id) != other.GetBool(id) : GetNumber(id) != other.GetNumber(id);
+	}
+
+	/// @return If true, the variable has a value
+	bool IsSet (int id) const
+	{
+		return Test(mSet, id);
+	}
+
+	/// @return Bool value, false if unset
+	bool GetBool (int id) const
+	{
+		return Test(mBools, id);
+	}
+
+	/// @return Number value, 0 if unset
+	double GetNumber (int id) const
+	{
+		return size_t(id) < mNumbers.size() ? mNumbers[id] : 0.0;
+	}
+
+	/// Makes room for an ID
+	void Reserve (int id)
+	{
+		size_t words = size_t(id) / eBits + 1;
+
+		if (mSet.size() < words) mSet.resize(words, 0);
+
+		if (mIsBools)
+		{
+			if (mBools.size() < words) mBools.resize(words, 0);
+		}
+
+		else if (mNumbers.size() <= size_t(id)) mNumbers.resize(words * eBits, 0.0);
+	}
+
+	/// Assigns a bool value
+	void SetBool (int id, bool bValue)
+	{
+		Reserve(id);
+
+		unsigned bit = 1u << (id % eBits);
+
+		mSet[id / eBits] |= bit;
+
+		if (bValue) mBools[id / eBits] |= bit;
+
+		else mBools[id / eBits] &= ~bit;
+
+		Mark(id);
+	}
+
+	/// Assigns a number value
+	void SetNumber (int id, double value)
+	{
+		Reserve(id);
+
+		mSet[id / eBits] |= 1u << (id % eBits);
+		mNumbers[id] = value;
+
+		Mark(id);
+	}
+
+	/// Unsets a variable
+	void Clear (int id)
+	{
+		if (!IsSet(id)) return;
+
+		unsigned bit = ~(1u << (id % eBits));
+
+		mSet[id / eBits] &= bit;
+
+		if (mIsBools) mBools[id / eBits] &= bit;
+
+		else mNumbers[id] = 0.0;
+
+		Mark(id);
+	}
+};
+
+/// Environment slots
+enum { eNames = 1, eIDs, eMeta };
+
+/// @return Store at an index
+static VarStore & Store (lua_State * L, int index)
+{
+	bool bIsStore = lua_getmetatable(L, index) != 0;// ...[, meta1]
+
+	if (bIsStore)
+	{
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eMeta);// ..., meta1, meta2
+
+		bIsStore = lua_rawequal(L, -2, -1) != 0;
+
+		lua_pop(L, 2);	// ...
+	}
+
+	if (!bIsStore) luaL_typerror(L, index, "VarStore");
+
+	return *(VarStore *)lua_touserdata(L, index);
+}
+
+/// @return ID of a variable key: either an ID, or a name, interned if requested; 0 if
+/// the name was never interned
+/// @remark A number that is a valid ID is taken as one; any other number is a name
+static int GetID (lua_State * L, int index, bool bIntern)
+{
+	if (lua_type(L, index) == LUA_TNUMBER)
+	{
+		lua_Number number = lua_tonumber(L, index);
+		int id = lua_tointeger(L, index);
+
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// ..., ids
+
+		bool bIsID = id > 0 && lua_Number(id) == number && size_t(id) <= lua_objlen(L, -1);
+
+		lua_pop(L, 1);	// ...
+
+		if (bIsID) return id;
+
+		luaL_argcheck(L, number == number, index, "NaN name");
+	}
+
+	luaL_argcheck(L, !lua_isnoneornil(L, index), index, "Nil name");
+
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eNames);	// ..., names
+	lua_pushvalue(L, index);// ..., names, name
+	lua_rawget(L, -2);	// ..., names, id?
+
+	int id = lua_tointeger(L, -1);
+
+	if (0 == id && bIntern)
+	{
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// ..., names, nil, ids
+
+		id = int(lua_objlen(L, -1)) + 1;
+
+		lua_pushvalue(L, index);// ..., names, nil, ids, name
+		lua_rawseti(L, -2, id);	// ..., names, nil, ids = { ..., name }
+		lua_pushvalue(L, index);// ..., names, nil, ids, name
+		lua_pushinteger(L, id);	// ..., names, nil, ids, name, id
+		lua_rawset(L, -5);	// ..., names = { ..., name = id }, nil, ids
+		lua_pop(L, 1);	// ..., names, nil
+	}
+
+	lua_pop(L, 2);	// ...
+
+	return id;
+}
+
+/// Pushes a variable's value, or @b nil if unset and requested
+static void PushValue (lua_State * L, const VarStore & store, int id, bool bNilIfUnset)
+{
+	if (bNilIfUnset && !store.IsSet(id)) lua_pushnil(L);	// ..., nil
+
+	else if (store.mIsBools) lua_pushboolean(L, store.GetBool(id));	// ..., bool
+
+	else lua_pushnumber(L, store.GetNumber(id));// ..., number
+}
+
+/// Bool store test over an array of variable keys
+/// @param bWant Result that ends the test early
+static int AuxTest (lua_State * L, bool bWant)
+{
+	VarStore & store = Store(L, 1);
+
+	luaL_argcheck(L, store.mIsBools, 1, "Not a bool store");
+	luaL_checktype(L, 2, LUA_TTABLE);
+
+	for (size_t i = 1, n = lua_objlen(L, 2); i <= n; ++i)
+	{
+		lua_rawgeti(L, 2, int(i));	// store, array, key
+
+		int id = GetID(L, 3, false);
+
+		lua_pop(L, 1);	// store, array
+
+		if ((id != 0 && store.GetBool(id)) == bWant)
+		{
+			lua_pushboolean(L, bWant);	// store, array, want
+
+			return 1;
+		}
+	}
+
+	lua_pushboolean(L, !bWant);	// store, array, !want
+
+	return 1;
+}
+
+/// Tests whether all bools in a store are true
+/// @remark Arguments: store, array of IDs or names
+/// @return If true, all bools were true (or the array was empty)
+static int AllTrue (lua_State * L)
+{
+	return AuxTest(L, false);
+}
+
+/// Tests whether any bool in a store is true
+/// @remark Arguments: store, array of IDs or names
+/// @return If true, at least one bool was true
+static int AnyTrue (lua_State * L)
+{
+	return AuxTest(L, true);
+}
+
+/// Overwrites a store's variables with those of another; watched variables that change
+/// are marked dirty
+/// @remark Arguments: dest, source
+static int Copy (lua_State * L)
+{
+	VarStore & dest = Store(L, 1), & source = Store(L, 2);
+
+	luaL_argcheck(L, dest.mIsBools == source.mIsBools, 2, "Store kinds differ");
+
+	for (size_t word = 0; word < dest.mWatched.size(); ++word)
+	{
+		for (unsigned bits = dest.mWatched[word]; bits; bits &= bits - 1)
+		{
+			int id = int(word * VarStore::eBits);
+
+			for (unsigned low = bits & (0u - bits); low > 1; low >>= 1) ++id;
+
+			if (dest.Differs(source, id)) dest.Mark(id);
+		}
+	}
+
+	dest.mSet = source.mSet;
+	dest.mBools = source.mBools;
+	dest.mNumbers = source.mNumbers;
+
+	return 0;
+}
+
+/// @remark Arguments: id
+/// @return Name interned under the ID, or @b nil if none
+static int GetName (lua_State * L)
+{
+	lua_Number number = luaL_checknumber(L, 1);
+	int id = int(number);
+
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// id, ids
+
+	if (lua_Number(id) == number) lua_rawgeti(L, -1, id);	// id, ids, name?
+
+	else lua_pushnil(L);// id, ids, nil
+
+	return 1;
+}
+
+/// @remark Arguments: store
+/// @return Fresh table with the set variables as (name, value) pairs
+static int GetVars (lua_State * L)
+{
+	VarStore & store = Store(L, 1);
+
+	lua_settop(L, 1);	// store
+	lua_newtable(L);// store, vars
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// store, vars, ids
+
+	for (size_t word = 0; word < store.mSet.size(); ++word)
+	{
+		for (unsigned bits = store.mSet[word]; bits; bits &= bits - 1)
+		{
+			int id = int(word * VarStore::eBits);
+
+			for (unsigned low = bits & (0u - bits); low > 1; low >>= 1) ++id;
+
+			lua_rawgeti(L, 3, id);	// store, vars, ids, name
+
+			PushValue(L, store, id, false);	// store, vars, ids, name, value
+
+			lua_rawset(L, 2);	// store, vars = { ..., name = value }, ids
+		}
+	}
+
+	lua_pop(L, 1);	// store, vars
+
+	return 1;
+}
+
+/// Interns a variable name
+/// @remark Arguments: name
+/// @return ID
+static int Intern (lua_State * L)
+{
+	luaL_argcheck(L, lua_type(L, 1) != LUA_TNUMBER, 1, "Numbers are already IDs");
+
+	lua_pushinteger(L, GetID(L, 1, true));	// name, id
+
+	return 1;
+}
+
+/// @remark Arguments: value
+/// @return If true, the value is a store
+static int IsStore (lua_State * L)
+{
+	bool bIsStore = lua_getmetatable(L, 1) != 0;// value[, meta1]
+
+	if (bIsStore)
+	{
+		lua_rawgeti(L, LUA_ENVIRONINDEX, eMeta);// value, meta1, meta2
+
+		bIsStore = lua_rawequal(L, -2, -1) != 0;
+	}
+
+	lua_pushboolean(L, bIsStore);	// ..., bIsStore
+
+	return 1;
+}
+
+/// Creates an empty store
+/// @remark Arguments: kind, which is "bools" or "nums"
+/// @return Store
+static int New (lua_State * L)
+{
+	const char * kinds[] = { "bools", "nums", 0 };
+
+	bool bIsBools = 0 == luaL_checkoption(L, 1, 0, kinds);
+
+	new (lua_newuserdata(L, sizeof(VarStore))) VarStore(bIsBools);// kind, store
+
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eMeta);// kind, store, meta
+	lua_setmetatable(L, -2);// kind, store
+
+	return 1;
+}
+
+/// Takes the dirty list, emptying it
+/// @remark Arguments: store, out
+/// @return Count of names written into @e out, starting at index 1
+static int TakeDirty (lua_State * L)
+{
+	VarStore & store = Store(L, 1);
+
+	luaL_checktype(L, 2, LUA_TTABLE);
+	lua_settop(L, 2);	// store, out
+	lua_rawgeti(L, LUA_ENVIRONINDEX, eIDs);	// store, out, ids
+
+	for (size_t i = 0; i < store.mDirty.size(); ++i)
+	{
+		int id = store.mDirty[i];
+
+		VarStore::Flag(store.mIsDirty, id, false);
+
+		lua_rawgeti(L, 3, id);	// store, out, ids, name
+		lua_rawseti(L, 2, int(i + 1));	// store, out = { ..., name }, ids
+	}
+
+	lua_pushinteger(L, int(store.mDirty.size()));	// store, out, ids, count
+
+	store.mDirty.clear();
+
+	return 1;
+}
+
+/// Starts or stops watching a variable
+/// @remark Arguments: store, ID or name, on
+static int Watch (lua_State * L)
+{
+	VarStore & store = Store(L, 1);
+
+	VarStore::Flag(store.mWatched, GetID(L, 2, true), lua_toboolean(L, 3) != 0);
+
+	return 0;
+}
+
+/// @remark Arguments: store, ID or name
+/// @return Variable's value, or @b nil if unset
+static int Peek (lua_State * L)
+{
+	VarStore & store = Store(L, 1);
+
+	PushValue(L, store, GetID(L, 2, false), true);	// store, key, value?
+
+	return 1;
+}
+
+/// @b __index metamethod: reads a variable by ID or name
+static int Index (lua_State * L)
+{
+	VarStore & store = *(VarStore *)lua_touserdata(L, 1);
+
+	PushValue(L, store, GetID(L, 2, false), false);	// store, key, value
+
+	return 1;
+}
+
+/// @b __newindex metamethod: assigns a variable by ID or name; @b nil unsets it
+static int NewIndex (lua_State * L)
+{
+	VarStore & store = *(VarStore *)lua_touserdata(L, 1);
+
+	int id = GetID(L, 2, !lua_isnil(L, 3));
+
+	if (lua_isnil(L, 3))
+	{
+		if (id != 0) store.Clear(id);
+	}
+
+	else if (store.mIsBools) store.SetBool(id, lua_toboolean(L, 3) != 0);
+
+	else store.SetNumber(id, luaL_checknumber(L, 3));
+
+	return 0;
+}
+
+/// Registers the var_store library
+int Bindings::open_varstore (lua_State * L)
+{
+	luaL_reg funcs[] = {
+		{ "AllTrue", AllTrue },
+		{ "AnyTrue", AnyTrue },
+		{ "Copy", Copy },
+		{ "GetName", GetName },
+		{ "GetVars", GetVars },
+		{ "Intern", Intern },
+		{ "IsStore", IsStore },
+		{ "New", New },
+		{ "Peek", Peek },
+		{ "TakeDirty", TakeDirty },
+		{ "Watch", Watch },
+		{ 0, 0 }
+	};
+
+	// Build the environment: the interned names, in both directions, and the store metatable.
+	lua_createtable(L, 3, 0);	// env
+	lua_newtable(L);// env, names
+	lua_rawseti(L, -2, eNames);	// env = { names }
+	lua_newtable(L);// env, ids
+	lua_rawseti(L, -2, eIDs);	// env = { names, ids }
+
+	const luaL_reg metamethods[] = {
+		{ "__gc", luaT_gc_dtor<VarStore> },
+		{ "__index", Index },
+		{ "__newindex", NewIndex },
+		{ 0, 0 }
+	};
+
+	lua_newtable(L);// env, meta
+
+	for (const luaL_reg * mm = metamethods; mm->name; ++mm)
+	{
+		lua_pushcfunction(L, mm->func);	// env, meta, func
+		lua_pushvalue(L, -3);	// env, meta, func, env
+		lua_setfenv(L, -2);	// env, meta, func
+		lua_setfield(L, -2, mm->name);	// env, meta = { ..., name = func }
+	}
+
+	lua_rawseti(L, -2, eMeta);	// env = { names, ids, meta }
+
+	Register(L, "var_store", funcs, -1);
+
+	lua_pop(L, 1);
+
+	return 0;
+}
@@ -0,0 +1,611 @@
+#include "stdafx.h"
+
+#include "Lua_/Lua.h"
+#include "Lua_/Arg.h"
+#include "Lua_/LibEx.h"
+#include "Lua_/Helpers.h"
+#include "Lua_/Templates.h"
+#include "Lua_/Handles.h"
+#include "Lua_/Vec3Array.h"
+#include <xmmintrin.h>
+
+using namespace Lua;
+
+namespace Lua
+{
+	/// Vec3Array type name
+	template<> const char * luaT_type<Vec3Array> (void) { return "Vec3Array"; }
+
+	/// Vec3Array handle type
+	LUAT_HANDLE_TYPE(Vec3Array, "Vec3ArrayHandle")
+
+	namespace Types
+	{
+		/// @param index Stack index
+		/// @return Reference to array
+		Vec3Array & Vec3Array_r (lua_State * L, int index)
+		{
+			return luaT_ref<Vec3Array>(L, index);
+		}
+
+		/// Reads a point, given either as a vector or as three numbers
+		/// @param index Stack index of point
+		/// @param p [out] Point components
+		/// @return Stack index following the point
+		int Point_ (lua_State * L, int index, float p[3])
+		{
+			if (lua_isnumber(L, index))
+			{
+				p[0] = F(L, index);
+				p[1] = F(L, index + 1);
+				p[2] = F(L, index + 2);
+
+				return index + 3;
+			}
+
+			luaL_argcheck(L, LUA_TestUserData(L, index, LUA_TYPE_VECTOR3), index, "Expected vector");
+
+			lua_Number * pVector = GET_VECTOR3(L, index);
+
+			p[0] = float(pVector[0]);
+			p[1] = float(pVector[1]);
+			p[2] = float(pVector[2]);
+
+			return index + 1;
+		}
+	}
+}
+
+/// Resizes the array, zeroing any new vectors and keeping the padding clear
+/// @param count New vector count
+void Vec3Array::Resize (size_t count)
+{
+	size_t old = mCount;
+
+	mCount = count;
+
+	size_t padded = Padded();
+
+	mX.resize(padded, 0.0f);
+	mY.resize(padded, 0.0f);
+	mZ.resize(padded, 0.0f);
+
+	// Clear out any new vectors and the padding past them. Kernels such as AddPoint work on
+	// whole groups, so lanes beyond the old count may hold stale values even when growing.
+	for (size_t i = count < old ? count : old; i < padded; ++i) mX[i] = mY[i] = mZ[i] = 0.0f;
+}
+
+/// Gets a 1-based vector index argument
+/// @param arr Array being indexed
+/// @param index Stack index of argument
+/// @return 0-based vector index
+static size_t GetSlot (lua_State * L, const Vec3Array & arr, int index)
+{
+	unsigned int slot = uI(L, index);
+
+	luaL_argcheck(L, slot >= 1 && slot <= arr.mCount, index, "Bad vector index");
+
+	return slot - 1;
+}
+
+/// Writes the indices of the lanes set in a series of movemask results
+/// @param masks Per-group movemask results
+/// @param arr Array that was tested
+/// @param out Stack index of optional results table
+/// @return 2 (results table and count)
+static int PushIndices (lua_State * L, const std::vector<int> & masks, const Vec3Array & arr, int out)
+{
+	std::vector<int> indices;
+
+	for (size_t g = 0; g < masks.size(); ++g)
+	{
+		for (int lane = 0, bits = masks[g]; bits != 0; ++lane, bits >>= 1)
+		{
+			size_t i = g * Vec3Array::eWidth + lane;
+
+			if ((bits & 1) != 0 && i < arr.mCount) indices.push_back(int(i + 1));
+		}
+	}
+
+	PrepOutTable(L, out, int(indices.size()));	// ..., out
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		lua_pushinteger(L, indices[i]);	// ..., out, index
+		lua_rawseti(L, -2, int(i + 1));	// ..., out = { ..., index }
+	}
+
+	lua_pushinteger(L, lua_Integer(indices.size()));// ..., out, count
+
+	return 2;
+}
+
+/// Writes a float array, up to the vector count, into a results table
+/// @param values Values to write
+/// @param arr Array that supplied the values
+/// @param out Stack index of optional results table
+/// @return 1 (results table)
+static int PushValues (lua_State * L, const float * values, const Vec3Array & arr, int out)
+{
+	PrepOutTable(L, out, int(arr.mCount));	// ..., out
+
+	for (size_t i = 0; i < arr.mCount; ++i)
+	{
+		lua_pushnumber(L, values[i]);	// ..., out, value
+		lua_rawseti(L, -2, int(i + 1));	// ..., out = { ..., value }
+	}
+
+	return 1;
+}
+
+/*%%%%%%%%%%%%%%%% KERNELS %%%%%%%%%%%%%%%%*/
+
+/// Loads one group of lanes
+#define LOAD_GROUP(arr, i) __m128 x = _mm_loadu_ps(&arr.mX[i]), y = _mm_loadu_ps(&arr.mY[i]), z = _mm_loadu_ps(&arr.mZ[i])
+
+/// Adds a point to every vector
+static void AddPoint (Vec3Array & arr, const float p[3])
+{
+	__m128 px = _mm_set1_ps(p[0]), py = _mm_set1_ps(p[1]), pz = _mm_set1_ps(p[2]);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		_mm_storeu_ps(&arr.mX[i], _mm_add_ps(x, px));
+		_mm_storeu_ps(&arr.mY[i], _mm_add_ps(y, py));
+		_mm_storeu_ps(&arr.mZ[i], _mm_add_ps(z, pz));
+	}
+}
+
+/// Adds another array's vectors, lane by lane
+static void AddArray (Vec3Array & arr, const Vec3Array & other)
+{
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		_mm_storeu_ps(&arr.mX[i], _mm_add_ps(x, _mm_loadu_ps(&other.mX[i])));
+		_mm_storeu_ps(&arr.mY[i], _mm_add_ps(y, _mm_loadu_ps(&other.mY[i])));
+		_mm_storeu_ps(&arr.mZ[i], _mm_add_ps(z, _mm_loadu_ps(&other.mZ[i])));
+	}
+}
+
+/// Scales every vector
+static void ScaleAll (Vec3Array & arr, float s)
+{
+	__m128 k = _mm_set1_ps(s);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		_mm_storeu_ps(&arr.mX[i], _mm_mul_ps(x, k));
+		_mm_storeu_ps(&arr.mY[i], _mm_mul_ps(y, k));
+		_mm_storeu_ps(&arr.mZ[i], _mm_mul_ps(z, k));
+	}
+}
+
+/// Computes reciprocal lengths, with 0 for zero-length vectors
+static __m128 InverseLength (__m128 x, __m128 y, __m128 z)
+{
+	__m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	__m128 nonzero = _mm_cmpgt_ps(len2, _mm_setzero_ps());
+
+	return _mm_and_ps(nonzero, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(len2)));
+}
+
+/// Normalizes every vector; zero-length vectors are left alone
+static void NormalizeAll (Vec3Array & arr)
+{
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		__m128 inv = InverseLength(x, y, z);
+
+		_mm_storeu_ps(&arr.mX[i], _mm_mul_ps(x, inv));
+		_mm_storeu_ps(&arr.mY[i], _mm_mul_ps(y, inv));
+		_mm_storeu_ps(&arr.mZ[i], _mm_mul_ps(z, inv));
+	}
+}
+
+/// Computes the dot product of every vector with a point
+static void DotAll (const Vec3Array & arr, const float p[3], float * out)
+{
+	__m128 px = _mm_set1_ps(p[0]), py = _mm_set1_ps(p[1]), pz = _mm_set1_ps(p[2]);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, px), _mm_mul_ps(y, py)), _mm_mul_ps(z, pz)));
+	}
+}
+
+/// Computes every vector's distance to a point (the origin gives plain lengths)
+static void DistanceAll (const Vec3Array & arr, const float p[3], float * out)
+{
+	__m128 px = _mm_set1_ps(p[0]), py = _mm_set1_ps(p[1]), pz = _mm_set1_ps(p[2]);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		__m128 dx = _mm_sub_ps(x, px), dy = _mm_sub_ps(y, py), dz = _mm_sub_ps(z, pz);
+
+		_mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))));
+	}
+}
+
+/// Masks vectors whose distance to a point is strictly between two ranges
+/// @remark Compares squared distances, so no square roots are taken
+static void RangeMasks (const Vec3Array & arr, const float p[3], float maxRange, float minRange, std::vector<int> & masks)
+{
+	__m128 px = _mm_set1_ps(p[0]), py = _mm_set1_ps(p[1]), pz = _mm_set1_ps(p[2]);
+	__m128 max2 = _mm_set1_ps(maxRange * maxRange), min2 = _mm_set1_ps(minRange < 0.0f ? -1.0f : minRange * minRange);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		__m128 dx = _mm_sub_ps(x, px), dy = _mm_sub_ps(y, py), dz = _mm_sub_ps(z, pz);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		masks.push_back(_mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(d2, max2), _mm_cmpgt_ps(d2, min2))));
+	}
+}
+
+/// Masks vectors whose normalized dot product with a normalized reference lies in a range
+/// @param lo Exclusive lower bound on the cosine
+/// @param hi Exclusive upper bound on the cosine
+static void AngleMasks (const Vec3Array & arr, const float r[3], float lo, float hi, std::vector<int> & masks)
+{
+	__m128 rx = _mm_set1_ps(r[0]), ry = _mm_set1_ps(r[1]), rz = _mm_set1_ps(r[2]);
+	__m128 rinv = InverseLength(rx, ry, rz), vlo = _mm_set1_ps(lo), vhi = _mm_set1_ps(hi);
+
+	for (size_t i = 0; i < arr.mCount; i += Vec3Array::eWidth)
+	{
+		LOAD_GROUP(arr, i);
+
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, rx), _mm_mul_ps(y, ry)), _mm_mul_ps(z, rz));
+		__m128 cosine = _mm_mul_ps(_mm_mul_ps(dot, rinv), InverseLength(x, y, z));
+
+		masks.push_back(_mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(cosine, vlo), _mm_cmplt_ps(cosine, vhi))));
+	}
+}
+
+#undef LOAD_GROUP
+
+/*%%%%%%%%%%%%%%%% METHODS %%%%%%%%%%%%%%%%*/
+
+/// Adds a point (vector or three numbers) or another array to every vector
+/// @remark Arrays must be the same size
+static int Add (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	if (lua_isuserdata(L, 2) && Class::IsType(L, 2, "Vec3Array"))
+	{
+		Vec3Array & other = Types::Vec3Array_r(L, 2);
+
+		luaL_argcheck(L, other.mCount == arr.mCount, 2, "Array size mismatch");
+
+		AddArray(arr, other);
+	}
+
+	else
+	{
+		float p[3];
+
+		Types::Point_(L, 2, p);
+		AddPoint(arr, p);
+	}
+
+	return 0;
+}
+
+/// Appends a vector, given as a vector or as three numbers
+/// @return New vector count
+static int Append (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float p[3];
+
+	Types::Point_(L, 2, p);
+
+	size_t i = arr.mCount;
+
+	arr.Resize(i + 1);
+
+	arr.mX[i] = p[0];
+	arr.mY[i] = p[1];
+	arr.mZ[i] = p[2];
+
+	lua_pushinteger(L, lua_Integer(arr.mCount));// arr, ..., count
+
+	return 1;
+}
+
+/// Removes all vectors
+static int Clear (lua_State * L)
+{
+	Types::Vec3Array_r(L, 1).Resize(0);
+
+	return 0;
+}
+
+/// Gets each vector's distance to a point
+/// @return Table of distances, in vector order
+/// @remark Arguments: point[, out]
+static int DistancesTo (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float p[3];
+
+	int out = Types::Point_(L, 2, p);
+
+	std::vector<float> dists(arr.Padded());
+
+	if (!dists.empty()) DistanceAll(arr, p, &dists[0]);
+
+	return PushValues(L, dists.empty() ? 0 : &dists[0], arr, out);
+}
+
+/// Gets each vector's dot product with a point
+/// @return Table of dot products, in vector order
+/// @remark Arguments: point[, out]
+static int Dots (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float p[3];
+
+	int out = Types::Point_(L, 2, p);
+
+	std::vector<float> dots(arr.Padded());
+
+	if (!dots.empty()) DotAll(arr, p, &dots[0]);
+
+	return PushValues(L, dots.empty() ? 0 : &dots[0], arr, out);
+}
+
+/// Gets a vector
+/// @return Components x, y, z; or, given a vector as argument #3, that vector, filled in
+static int Get (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	size_t i = GetSlot(L, arr, 2);
+
+	if (!lua_isnoneornil(L, 3))
+	{
+		VECTOR v;
+
+		v.x = arr.mX[i];
+		v.y = arr.mY[i];
+		v.z = arr.mZ[i];
+
+		CreateVector3(L, v, 3);	// arr, i, v
+
+		return 1;
+	}
+
+	lua_pushnumber(L, arr.mX[i]);	// arr, i, x
+	lua_pushnumber(L, arr.mY[i]);	// arr, i, x, y
+	lua_pushnumber(L, arr.mZ[i]);	// arr, i, x, y, z
+
+	return 3;
+}
+
+/// Finds vectors whose angle to a reference is within range, i.e. whose normalized dot
+/// product with it lies strictly between -range and range
+/// @return Table of indices, and their count
+/// @remark Arguments: reference, range[, out]
+/// @remark Batch analogue of script_helpers.IsVectorInAngleRange
+static int InAngleRange (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float r[3];
+
+	int arg = Types::Point_(L, 2, r);
+	float range = F(L, arg);
+
+	std::vector<int> masks;
+
+	AngleMasks(arr, r, -range, range, masks);
+
+	return PushIndices(L, masks, arr, arg + 1);
+}
+
+/// Finds vectors pointing the same way as a direction, i.e. whose dot product with it is positive
+/// @return Table of indices, and their count
+/// @remark Arguments: direction[, out]
+/// @remark Batch analogue of script_helpers.IsInFront
+static int InFront (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float d[3];
+
+	int out = Types::Point_(L, 2, d);
+
+	std::vector<int> masks;
+
+	AngleMasks(arr, d, 0.0f, 2.0f, masks);
+
+	return PushIndices(L, masks, arr, out);
+}
+
+/// Finds vectors whose distance to a point is within range
+/// @return Table of indices, and their count
+/// @remark Arguments: point, max_range[, min_range[, out]]
+/// @remark Batch analogue of script_helpers.IsInRange
+static int InRange (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float p[3];
+
+	int arg = Types::Point_(L, 2, p);
+	float maxRange = F(L, arg);
+	float minRange = float(luaL_optnumber(L, arg + 1, 0.0));
+
+	std::vector<int> masks;
+
+	RangeMasks(arr, p, maxRange, minRange, masks);
+
+	return PushIndices(L, masks, arr, arg + 2);
+}
+
+/// Gets each vector's length
+/// @return Table of lengths, in vector order
+/// @remark Arguments: [out]
+static int Lengths (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	float origin[3] = { 0.0f, 0.0f, 0.0f };
+
+	std::vector<float> lens(arr.Padded());
+
+	if (!lens.empty()) DistanceAll(arr, origin, &lens[0]);
+
+	return PushValues(L, lens.empty() ? 0 : &lens[0], arr, 2);
+}
+
+/// Normalizes every vector
+static int Normalize (lua_State * L)
+{
+	NormalizeAll(Types::Vec3Array_r(L, 1));
+
+	return 0;
+}
+
+/// Resizes the array; new vectors are zero
+static int Resize (lua_State * L)
+{
+	Types::Vec3Array_r(L, 1).Resize(uI(L, 2));
+
+	return 0;
+}
+
+/// Scales every vector
+static int Scale (lua_State * L)
+{
+	ScaleAll(Types::Vec3Array_r(L, 1), F(L, 2));
+
+	return 0;
+}
+
+/// Sets a vector, given as a vector or as three numbers
+static int Set (lua_State * L)
+{
+	Vec3Array & arr = Types::Vec3Array_r(L, 1);
+
+	size_t i = GetSlot(L, arr, 2);
+
+	float p[3];
+
+	Types::Point_(L, 3, p);
+
+	arr.mX[i] = p[0];
+	arr.mY[i] = p[1];
+	arr.mZ[i] = p[2];
+
+	return 0;
+}
+
+/// Metamethod
+/// @return Vector count
+static int Len (lua_State * L)
+{
+	lua_pushinteger(L, lua_Integer(Types::Vec3Array_r(L, 1).mCount));	// arr, count
+
+	return 1;
+}
+
+/// Constructor
+/// @remark Arguments: [count]
+static int Cons (lua_State * L)
+{
+	Vec3Array * arr = new (UD(L, 1)) Vec3Array;
+
+	if (!lua_isnoneornil(L, 2)) arr->Resize(uI(L, 2));
+
+	return 0;
+}
+
+/// Handle constructor
+/// @remark Arguments: [count]
+/// @remark The new handle owns its array, which is retired when it is collected or by
+/// Destroy(); copies, made by constructing a handle from another, go stale at that point
+static int HandleCons (lua_State * L)
+{
+	if (Class::IsType(L, 2, "Vec3ArrayHandle")) return luaT_cons_handle_copy<Vec3Array>(L);
+
+	luaT_cons_handle<Vec3Array>(L);
+
+	if (!lua_isnoneornil(L, 2)) luaT_handle_check<Vec3Array>(L, 1)->Resize(uI(L, 2));
+
+	return 0;
+}
+
+/// Binds the Vec3Array class
+int Bindings::open_vec3array (lua_State * L)
+{
+	luaL_reg methods[] = {
+		{ "Add", Add },
+		{ "Append", Append },
+		{ "Clear", Clear },
+		{ "DistancesTo", DistancesTo },
+		{ "Dots", Dots },
+		{ "Get", Get },
+		{ "InAngleRange", InAngleRange },
+		{ "InFront", InFront },
+		{ "InRange", InRange },
+		{ "Lengths", Lengths },
+		{ "Normalize", Normalize },
+		{ "Resize", Resize },
+		{ "Scale", Scale },
+		{ "Set", Set },
+		{ "__cons", Cons },
+		{ "__gc", luaT_gc_dtor<Vec3Array> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "Vec3Array", methods, Class::Def(sizeof(Vec3Array)));
+
+	// Handle variant: the arrays live in a handle table, so batch code can walk them
+	// densely and handles copy without touching the arrays.
+	luaL_reg handle_methods[] = {
+		{ "Add", Add },
+		{ "Append", Append },
+		{ "Clear", Clear },
+		{ "Destroy", luaT_handle_remove<Vec3Array> },
+		{ "DistancesTo", DistancesTo },
+		{ "Dots", Dots },
+		{ "Get", Get },
+		{ "InAngleRange", InAngleRange },
+		{ "InFront", InFront },
+		{ "InRange", InRange },
+		{ "IsValid", luaT_handle_is_valid<Vec3Array> },
+		{ "Lengths", Lengths },
+		{ "Normalize", Normalize },
+		{ "Resize", Resize },
+		{ "Scale", Scale },
+		{ "Set", Set },
+		{ "__cons", HandleCons },
+		{ "__gc", luaT_gc_handle<Vec3Array> },
+		{ "__len", Len },
+		{ 0, 0 }
+	};
+
+	Class::Define(L, "Vec3ArrayHandle", handle_methods, Class::Def(sizeof(Handle)));
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef LUA_VEC3_ARRAY_H
+#define LUA_VEC3_ARRAY_H
+
+#include "Lua_/Lua.h"
+#include <vector>
+
+/// Structure-of-arrays storage for 3-vectors
+/// @remark Component arrays are padded with zeroes to a multiple of the SIMD width, so
+/// kernels may run over whole lanes without a scalar tail
+struct Vec3Array {
+	enum { eWidth = 4 };///< SIMD lane count
+
+	std::vector<float> mX;	///< x components
+	std::vector<float> mY;	///< y components
+	std::vector<float> mZ;	///< z components
+	size_t mCount;	///< Count of live vectors
+
+	Vec3Array (void) : mCount(0) {}
+
+	/// @return Count rounded up to the SIMD width
+	size_t Padded (void) const { return (mCount + eWidth - 1) & ~size_t(eWidth - 1); }
+
+	void Resize (size_t count);
+};
+
+namespace Lua
+{
+	namespace Types
+	{
+		G2GAME_IMPEXP Vec3Array & Vec3Array_r (lua_State * L, int index);
+
+		G2GAME_IMPEXP int Point_ (lua_State * L, int index, float p[3]);
+	}
+}
+
+#endif // LUA_VEC3_ARRAY_H
\ No newline at end of file